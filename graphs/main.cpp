@@ -7,68 +7,4151 @@
 #include <algorithm>
 #include <queue>
 #include <sstream>
+#include <iomanip>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <filesystem>
 #include <set>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <cstring>
 
+// On x86 with GCC or Clang the AVX2 and AVX-512 kernels are compiled whatever -march says and chosen at run
+// time from the CPU (see CpuHasAVX2). Other compilers get them only when the build enables the instruction set.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAPH_SIMD_DISPATCH 1
+#define GRAPH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define GRAPH_TARGET(isa)
+#endif
+#if defined(GRAPH_SIMD_DISPATCH) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(GRAPH_SIMD_DISPATCH) || defined(__AVX2__)
+#define GRAPH_HAS_AVX2_KERNELS 1
+#endif
+#if defined(GRAPH_SIMD_DISPATCH) || defined(__AVX512F__)
+#define GRAPH_HAS_AVX512_KERNELS 1
+#endif
+
+// With GRAPH_HEADLESS defined only the command-line modes are built: imgui.h is used for ImVec2 alone and
+// nothing needs GLFW, OpenGL or a display
 #include <imgui.h>
+#ifndef GRAPH_HEADLESS
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
+#endif
+
+// Data Structures
+struct Node {
+    ImVec2 position;
+    std::string label;
+    bool selected = false;
+    bool dragging = false;
+    ImVec2 drag_offset;
+    float radius;
+    int connection_count = 0;
+    std::string type; // from the subj_type / obj_type columns, if the data has them
+};
+
+struct Edge {
+    int from, to;
+    std::string predicate;
+    std::string severity;
+};
+
+// Struct for raw data from file
+struct Triple {
+    std::string node_name;
+    std::string edge_name;
+    std::string name_of_component;
+    std::string severity;
+    std::string subject_type; // optional subj_type / obj_type columns, empty when absent
+    std::string object_type;
+};
+
+bool operator==(const Triple& a, const Triple& b) {
+    return a.node_name == b.node_name && a.edge_name == b.edge_name && a.name_of_component == b.name_of_component &&
+           a.severity == b.severity && a.subject_type == b.subject_type && a.object_type == b.object_type;
+}
+
+// Helper function to convert severity to a numerical weight with more variability
+float severityToWeight(const std::string& severity) {
+    if (severity == "high") return 0.8f;
+    if (severity == "medium") return 0.4f;
+    if (severity == "low") return 0.1f;
+    return 0.0f;
+}
+
+// Compressed sparse row adjacency: neighbors of v are neighbors[offsets[v] .. offsets[v + 1]), ascending
+struct CSRGraph {
+    std::vector<int> offsets;
+    std::vector<int> neighbors;
+
+    int numNodes() const { return offsets.empty() ? 0 : (int)offsets.size() - 1; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const int* begin(int v) const { return neighbors.data() + offsets[v]; }
+    const int* end(int v) const { return neighbors.data() + offsets[v + 1]; }
+};
+
+CSRGraph BuildCSR(const std::vector<std::set<int>>& adjacency) {
+    CSRGraph g;
+    int n = adjacency.size();
+    g.offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        g.offsets[v + 1] = g.offsets[v] + (int)adjacency[v].size();
+    }
+    g.neighbors.reserve(g.offsets[n]);
+    for (int v = 0; v < n; ++v) {
+        g.neighbors.insert(g.neighbors.end(), adjacency[v].begin(), adjacency[v].end());
+    }
+    return g;
+}
+
+int WorkerCount() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : (int)hw;
+}
+
+// Persistent workers behind ParallelFor, so per-frame work like the layout step does not pay for thread
+// creation. run() executes job(worker) once on every worker, with the caller as worker 0, and returns when
+// all of them are done. Jobs from different threads take turns; a ParallelFor issued from inside a job
+// runs inline on that thread.
+class ThreadPool {
+public:
+    explicit ThreadPool(int workers) {
+        for (int w = 1; w < workers; ++w) threads.emplace_back([this, w] { workerLoop(w); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    int size() const { return (int)threads.size() + 1; }
+
+    static bool insideJob() { return inside_job; }
+
+    void run(const std::function<void(int)>& task) {
+        std::lock_guard<std::mutex> submit_lock(submit_mutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            pending = threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        inside_job = true;
+        task(0);
+        inside_job = false;
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex submit_mutex;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    unsigned long long generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+    static thread_local bool inside_job;
+
+    void workerLoop(int worker) {
+        unsigned long long seen = 0;
+        for (;;) {
+            const std::function<void(int)>* task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                task = job;
+            }
+            inside_job = true;
+            (*task)(worker);
+            inside_job = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending--;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+thread_local bool ThreadPool::inside_job = false;
+
+ThreadPool& DefaultPool() {
+    static ThreadPool pool(WorkerCount());
+    return pool;
+}
+
+// Runs fn(range_begin, range_end, worker) over [begin, end) in chunks of `grain`, claimed dynamically so
+// skewed work (hub nodes) balances itself. Ranges of a single chunk, and calls made from inside another
+// ParallelFor, run inline on the calling thread.
+template <typename Fn>
+void ParallelFor(int begin, int end, int grain, Fn&& fn) {
+    if (end <= begin) return;
+    int chunks = (end - begin + grain - 1) / grain;
+    if (chunks <= 1 || WorkerCount() <= 1 || ThreadPool::insideJob()) {
+        fn(begin, end, 0);
+        return;
+    }
+    std::atomic<int> next(begin);
+    DefaultPool().run([&](int worker) {
+        for (;;) {
+            int b = next.fetch_add(grain);
+            if (b >= end) break;
+            fn(b, std::min(end, b + grain), worker);
+        }
+    });
+}
+
+bool CpuHasAVX2() {
+#if defined(GRAPH_SIMD_DISPATCH)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#elif defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool CpuHasAVX512() {
+#if defined(GRAPH_SIMD_DISPATCH)
+    static const bool supported = __builtin_cpu_supports("avx512f");
+    return supported;
+#elif defined(__AVX512F__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(GRAPH_HAS_AVX2_KERNELS)
+// Merges 8x8 blocks of a and b from (i, j) on, comparing each block by rotating b through all lanes
+GRAPH_TARGET("avx2") void IntersectBlocksAVX2(const int* a, int na, const int* b, int nb, int& i, int& j, int& count) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        __m256i match = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; ++r) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+        }
+        count += (int)std::bitset<8>(_mm256_movemask_ps(_mm256_castsi256_ps(match))).count();
+        int a_max = a[i + 7], b_max = b[j + 7];
+        if (a_max <= b_max) i += 8;
+        if (b_max <= a_max) j += 8;
+    }
+}
+#endif
+
+// Size of the intersection of two ascending, duplicate-free ranges
+int IntersectCount(const int* a, int na, const int* b, int nb) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    int count = 0;
+    // Very skewed sizes (a hub against a leaf): binary-search the short side instead of merging
+    if (na * 32 < nb) {
+        const int* lo = b;
+        const int* hi = b + nb;
+        for (int i = 0; i < na && lo < hi; ++i) {
+            lo = std::lower_bound(lo, hi, a[i]);
+            if (lo < hi && *lo == a[i]) count++;
+        }
+        return count;
+    }
+    int i = 0, j = 0;
+#if defined(GRAPH_HAS_AVX2_KERNELS)
+    if (CpuHasAVX2()) IntersectBlocksAVX2(a, na, b, nb, i, j, count);
+#endif
+#if defined(__SSE2__)
+    // Whatever 4x4 blocks are left, or all of them without AVX2
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        __m128i match = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        count += (int)std::bitset<4>(_mm_movemask_ps(_mm_castsi128_ps(match))).count();
+        int a_max = a[i + 3], b_max = b[j + 3];
+        if (a_max <= b_max) i += 4;
+        if (b_max <= a_max) j += 4;
+    }
+#endif
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) i++;
+        else if (a[i] > b[j]) j++;
+        else { count++; i++; j++; }
+    }
+    return count;
+}
+
+int LowestSetBit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while (!((bits >> bit) & 1)) bit++;
+    return bit;
+#endif
+}
+
+// PCG32 (O'Neill 2014): small and fast, and the same sequence on every platform, unlike the <random>
+// distributions whose output is implementation-defined. Different streams of one seed are independent, so
+// parallel code can give every chunk its own generator.
+struct Pcg32 {
+    uint64_t state = 0, increment = 1;
+
+    explicit Pcg32(uint64_t seed = 1, uint64_t stream = 0) {
+        increment = (stream << 1u) | 1u;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = uint32_t(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    uint32_t below(uint32_t bound) { return uint32_t(((uint64_t)next() * bound) >> 32); }
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); } // [0, 1)
+};
+
+struct TriangleStats {
+    std::vector<double> per_node; // triangles touching each node (an estimate when sampled)
+    double total = 0.0;
+    bool sampled = false;
+};
+
+// Exact mode orients every edge from lower to higher (degree, id) rank, so each triangle is seen once at its
+// lowest node and the forward lists stay short even around hubs. For a node x:
+//   lowest  : sum over y in fwd(x) of |fwd(x) & fwd(y)|
+//   other   : sum over y in bwd(x) of |fwd(y) & N(x)|   (y is the lowest, x the middle or highest)
+// Sampled mode keeps each incident edge with probability sample_rate and scales the wedge-closure counts.
+TriangleStats CountTriangles(const CSRGraph& g, float sample_rate = 1.0f, unsigned seed = 1) {
+    TriangleStats stats;
+    int n = g.numNodes();
+    stats.per_node.assign(n, 0.0);
+    if (n == 0) return stats;
+
+    if (sample_rate < 1.0f) {
+        stats.sampled = true;
+        ParallelFor(0, n, 64, [&](int begin, int end, int) {
+            for (int x = begin; x < end; ++x) {
+                Pcg32 rng(seed, x);
+                double closed = 0.0;
+                for (const int* y = g.begin(x); y != g.end(x); ++y) {
+                    if (rng.uniform() >= sample_rate) continue;
+                    closed += IntersectCount(g.begin(x), g.degree(x), g.begin(*y), g.degree(*y));
+                }
+                stats.per_node[x] = closed / (2.0 * sample_rate);
+            }
+        });
+        for (double t : stats.per_node) stats.total += t;
+        stats.total /= 3.0;
+        return stats;
+    }
+
+    auto ranks_below = [&](int u, int v) {
+        return g.degree(u) < g.degree(v) || (g.degree(u) == g.degree(v) && u < v);
+    };
+    CSRGraph fwd, bwd;
+    fwd.offsets.assign(n + 1, 0);
+    bwd.offsets.assign(n + 1, 0);
+    for (int u = 0; u < n; ++u) {
+        int up = 0;
+        for (const int* v = g.begin(u); v != g.end(u); ++v) {
+            if (ranks_below(u, *v)) up++;
+        }
+        fwd.offsets[u + 1] = fwd.offsets[u] + up;
+        bwd.offsets[u + 1] = bwd.offsets[u] + g.degree(u) - up;
+    }
+    fwd.neighbors.resize(fwd.offsets[n]);
+    bwd.neighbors.resize(bwd.offsets[n]);
+    ParallelFor(0, n, 256, [&](int begin, int end, int) {
+        for (int u = begin; u < end; ++u) {
+            int f = fwd.offsets[u], b = bwd.offsets[u];
+            for (const int* v = g.begin(u); v != g.end(u); ++v) {
+                if (ranks_below(u, *v)) fwd.neighbors[f++] = *v;
+                else bwd.neighbors[b++] = *v;
+            }
+        }
+    });
+
+    std::vector<double> lowest(n, 0.0);
+    ParallelFor(0, n, 64, [&](int begin, int end, int) {
+        for (int x = begin; x < end; ++x) {
+            double as_lowest = 0.0, as_other = 0.0;
+            for (const int* y = fwd.begin(x); y != fwd.end(x); ++y) {
+                as_lowest += IntersectCount(fwd.begin(x), fwd.degree(x), fwd.begin(*y), fwd.degree(*y));
+            }
+            for (const int* y = bwd.begin(x); y != bwd.end(x); ++y) {
+                as_other += IntersectCount(fwd.begin(*y), fwd.degree(*y), g.begin(x), g.degree(x));
+            }
+            lowest[x] = as_lowest;
+            stats.per_node[x] = as_lowest + as_other;
+        }
+    });
+    for (double t : lowest) stats.total += t;
+    return stats;
+}
+
+// Builds a CSR from an edge list. Symmetric graphs get both directions; rows are sorted and deduplicated.
+CSRGraph BuildCSRFromEdges(int n, const std::vector<std::pair<int, int>>& edge_list, bool symmetric) {
+    CSRGraph g;
+    g.offsets.assign(n + 1, 0);
+    for (const auto& e : edge_list) {
+        g.offsets[e.first + 1]++;
+        if (symmetric) g.offsets[e.second + 1]++;
+    }
+    for (int v = 0; v < n; ++v) g.offsets[v + 1] += g.offsets[v];
+    g.neighbors.resize(g.offsets[n]);
+    std::vector<int> fill(g.offsets.begin(), g.offsets.end() - 1);
+    for (const auto& e : edge_list) {
+        g.neighbors[fill[e.first]++] = e.second;
+        if (symmetric) g.neighbors[fill[e.second]++] = e.first;
+    }
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) {
+            std::sort(g.neighbors.begin() + g.offsets[v], g.neighbors.begin() + g.offsets[v + 1]);
+            fill[v] = std::unique(g.neighbors.begin() + g.offsets[v], g.neighbors.begin() + g.offsets[v + 1]) - g.neighbors.begin();
+        }
+    });
+    int write = 0;
+    for (int v = 0; v < n; ++v) {
+        int begin = g.offsets[v];
+        g.offsets[v] = write;
+        for (int i = begin; i < fill[v]; ++i) {
+            if (g.neighbors[i] != v) g.neighbors[write++] = g.neighbors[i];
+        }
+    }
+    g.offsets[n] = write;
+    g.neighbors.resize(write);
+    return g;
+}
+
+// Grows a CSR built by BuildCSRFromEdges to n nodes and merges (row, value) pairs into its sorted rows, skipping
+// pairs it already has. Works in place from the last row back, so rows before the lowest one touched (or the
+// first new node) are not moved: appends cost the pairs plus a memmove of the rows after that.
+void InsertIntoCSR(CSRGraph& g, int n, std::vector<std::pair<int, int>> additions) {
+    int old_n = g.numNodes();
+    if (g.offsets.empty()) g.offsets.push_back(0);
+    std::sort(additions.begin(), additions.end());
+    additions.erase(std::unique(additions.begin(), additions.end()), additions.end());
+    additions.erase(std::remove_if(additions.begin(), additions.end(), [&](const std::pair<int, int>& a) {
+        return a.first < old_n && std::binary_search(g.begin(a.first), g.end(a.first), a.second);
+    }), additions.end());
+    int old_total = g.offsets[old_n];
+    g.offsets.resize(n + 1, old_total);
+    int first_row = std::min(old_n, additions.empty() ? n : additions[0].first);
+    g.neighbors.resize(g.neighbors.size() + additions.size());
+    int* out = g.neighbors.data();
+    int added = additions.size();
+    for (int row = n - 1; row >= first_row; --row) {
+        int old_begin = g.offsets[row], old_end = g.offsets[row + 1];
+        int row_end = added;
+        while (added > 0 && additions[added - 1].first == row) added--;
+        // Merge from the back: every row moves right by the additions before it, so writes never pass reads
+        int write = old_end + row_end, read = old_end, next = row_end;
+        while (next > added) {
+            if (read > old_begin && out[read - 1] > additions[next - 1].second) out[--write] = out[--read];
+            else out[--write] = additions[--next].second;
+        }
+        if (write != read) std::copy_backward(out + old_begin, out + read, out + write);
+        g.offsets[row + 1] = old_end + row_end;
+    }
+}
+
+// Parts of a graph a traversal must not enter. Slot masks index the CSR being traversed, so they are only
+// meaningful when the same symmetric graph is passed as both `out` and `in`, with both directions marked.
+struct BFSFilter {
+    const std::vector<char>* removed_nodes = nullptr;
+    const std::vector<char>* removed_slots = nullptr;
+
+    bool blocksNode(int v) const { return removed_nodes && (*removed_nodes)[v]; }
+    bool blocksSlot(int slot) const { return removed_slots && (*removed_slots)[slot]; }
+};
+
+// Direction-optimizing breadth-first search (Beamer, Asanovic, Patterson). Levels expand top-down from a
+// queue while the frontier is small and switch to bottom-up, where every unvisited node scans its
+// in-neighbors against a frontier bitmap, once the frontier's edges outweigh the unexplored ones. Both
+// directions expand in parallel. Scratch is reused between runs and short runs only reset what they
+// touched, so depth-limited searches stay proportional to the region they reach.
+class BFSEngine {
+public:
+    enum class Direction { Optimizing, TopDownOnly };
+    Direction direction = Direction::Optimizing;
+    int bottom_up_levels = 0; // levels of the last run that were expanded bottom-up
+
+    // `in` is the reverse of `out` and is only read by bottom-up levels; pass the same graph twice when
+    // the graph is undirected
+    void run(const CSRGraph& out, const CSRGraph& in, const std::vector<int>& sources,
+             int max_depth = std::numeric_limits<int>::max(), const BFSFilter& filter = BFSFilter()) {
+        reset(out.numNodes());
+        this->filter = filter;
+        for (int s : sources) {
+            if (s >= 0 && s < n && !filter.blocksNode(s) && claim(s)) {
+                depths[s] = 0;
+                visit_order.push_back(s);
+            }
+        }
+        level_offsets.push_back(visit_order.size());
+
+        long long unexplored_edges = out.neighbors.size();
+        for (int v : visit_order) unexplored_edges -= out.degree(v);
+        bool bottom_up = false;
+        for (int level = 1; level <= max_depth; ++level) {
+            int frontier_begin = level_offsets[level - 1];
+            int frontier_end = level_offsets[level];
+            if (frontier_begin == frontier_end) break;
+
+            if (direction == Direction::Optimizing) {
+                long long frontier_edges = 0;
+                for (int i = frontier_begin; i < frontier_end; ++i) frontier_edges += out.degree(visit_order[i]);
+                int frontier_size = frontier_end - frontier_begin;
+                if (!bottom_up && frontier_edges > unexplored_edges / kAlpha) bottom_up = true;
+                else if (bottom_up && frontier_size < n / kBeta) bottom_up = false;
+            }
+            if (bottom_up) {
+                stepBottomUp(in, frontier_begin, frontier_end, level);
+                bottom_up_levels++;
+            } else {
+                stepTopDown(out, frontier_begin, frontier_end, level);
+            }
+
+            // Canonical order within a level, independent of how the work was split between threads
+            size_t level_begin = visit_order.size();
+            for (auto& local : worker_next) {
+                visit_order.insert(visit_order.end(), local.begin(), local.end());
+                local.clear();
+            }
+            std::sort(visit_order.begin() + level_begin, visit_order.end());
+            for (size_t i = level_begin; i < visit_order.size(); ++i) unexplored_edges -= out.degree(visit_order[i]);
+            if (level_begin == visit_order.size()) break;
+            level_offsets.push_back(visit_order.size());
+        }
+    }
+
+    void run(const CSRGraph& g, int source, int max_depth = std::numeric_limits<int>::max(),
+             const BFSFilter& filter = BFSFilter()) {
+        run(g, g, std::vector<int>{source}, max_depth, filter);
+    }
+
+    // Hop distance from the nearest source, -1 if the last run did not reach v
+    int depth(int v) const { return depths[v]; }
+    // Reached nodes, level by level; level l is order()[levelOffsets()[l] .. levelOffsets()[l + 1])
+    const std::vector<int>& order() const { return visit_order; }
+    const std::vector<int>& levelOffsets() const { return level_offsets; }
+    int levels() const { return (int)level_offsets.size() - 1; }
+
+private:
+    static constexpr int kAlpha = 14;
+    static constexpr int kBeta = 24;
+
+    int n = -1;
+    BFSFilter filter;
+    std::vector<int> depths;
+    std::unique_ptr<std::atomic<uint64_t>[]> visited;
+    std::vector<uint64_t> frontier_bits;
+    std::vector<int> visit_order;
+    std::vector<int> level_offsets;
+    std::vector<std::vector<int>> worker_next;
+
+    int words() const { return (n + 63) / 64; }
+
+    bool claim(int v) {
+        uint64_t bit = uint64_t(1) << (v & 63);
+        if (visited[v >> 6].load(std::memory_order_relaxed) & bit) return false;
+        return !(visited[v >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    void reset(int nodes) {
+        if (nodes != n) {
+            n = nodes;
+            depths.assign(n, -1);
+            visited.reset(new std::atomic<uint64_t>[words()]);
+            for (int w = 0; w < words(); ++w) visited[w].store(0, std::memory_order_relaxed);
+            frontier_bits.assign(words(), 0);
+        } else if (visit_order.size() * 64 < (size_t)n) {
+            for (int v : visit_order) {
+                depths[v] = -1;
+                visited[v >> 6].store(0, std::memory_order_relaxed);
+            }
+        } else {
+            std::fill(depths.begin(), depths.end(), -1);
+            for (int w = 0; w < words(); ++w) visited[w].store(0, std::memory_order_relaxed);
+        }
+        visit_order.clear();
+        level_offsets.assign(1, 0);
+        worker_next.resize(WorkerCount());
+        bottom_up_levels = 0;
+    }
+
+    void stepTopDown(const CSRGraph& out, int frontier_begin, int frontier_end, int level) {
+        ParallelFor(frontier_begin, frontier_end, 64, [&](int begin, int end, int worker) {
+            std::vector<int>& next = worker_next[worker];
+            for (int i = begin; i < end; ++i) {
+                int u = visit_order[i];
+                for (int slot = out.offsets[u]; slot < out.offsets[u + 1]; ++slot) {
+                    int v = out.neighbors[slot];
+                    if (filter.blocksSlot(slot) || filter.blocksNode(v)) continue;
+                    if (claim(v)) {
+                        depths[v] = level;
+                        next.push_back(v);
+                    }
+                }
+            }
+        });
+    }
+
+    void stepBottomUp(const CSRGraph& in, int frontier_begin, int frontier_end, int level) {
+        std::fill(frontier_bits.begin(), frontier_bits.end(), 0);
+        for (int i = frontier_begin; i < frontier_end; ++i) {
+            int u = visit_order[i];
+            frontier_bits[u >> 6] |= uint64_t(1) << (u & 63);
+        }
+        // Chunks are whole bitmap words, so no two threads ever publish into the same word
+        ParallelFor(0, words(), 16, [&](int word_begin, int word_end, int worker) {
+            std::vector<int>& next = worker_next[worker];
+            for (int word = word_begin; word < word_end; ++word) {
+                uint64_t seen = visited[word].load(std::memory_order_relaxed);
+                if (seen == ~uint64_t(0)) continue;
+                uint64_t found = 0;
+                for (int bit = 0; bit < 64; ++bit) {
+                    int v = word * 64 + bit;
+                    if (v >= n) break;
+                    if ((seen & (uint64_t(1) << bit)) || filter.blocksNode(v)) continue;
+                    for (int slot = in.offsets[v]; slot < in.offsets[v + 1]; ++slot) {
+                        int u = in.neighbors[slot];
+                        if (filter.blocksSlot(slot)) continue;
+                        if (frontier_bits[u >> 6] & (uint64_t(1) << (u & 63))) {
+                            found |= uint64_t(1) << bit;
+                            depths[v] = level;
+                            next.push_back(v);
+                            break;
+                        }
+                    }
+                }
+                if (found) visited[word].fetch_or(found, std::memory_order_relaxed);
+            }
+        });
+    }
+};
+
+// A node-induced subgraph with its own dense ids; original_ids maps each local id back to the source graph
+struct Subgraph {
+    std::vector<int> original_ids;
+    std::vector<int> hops; // distance from the center, non-decreasing in local id order
+    CSRGraph csr;
+};
+
+// Extracts k-hop neighborhoods on top of a depth-limited BFSEngine run. The relabeling table is kept
+// between calls and only the entries a query touched are reset, so each extraction costs time
+// proportional to the region it returns.
+class EgoNetworkExtractor {
+public:
+    Subgraph extract(const CSRGraph& g, int center, int k) {
+        Subgraph sub;
+        int n = g.numNodes();
+        if (center < 0 || center >= n || k < 0) return sub;
+        if ((int)local_id.size() != n) local_id.assign(n, -1);
+
+        bfs.run(g, center, k);
+        sub.original_ids = bfs.order();
+        int m = sub.original_ids.size();
+        sub.hops.resize(m);
+        for (int i = 0; i < m; ++i) {
+            sub.hops[i] = bfs.depth(sub.original_ids[i]);
+            local_id[sub.original_ids[i]] = i;
+        }
+
+        sub.csr.offsets.assign(m + 1, 0);
+        for (int i = 0; i < m; ++i) {
+            int u = sub.original_ids[i];
+            for (const int* v = g.begin(u); v != g.end(u); ++v) {
+                if (local_id[*v] >= 0) sub.csr.neighbors.push_back(local_id[*v]);
+            }
+            sub.csr.offsets[i + 1] = sub.csr.neighbors.size();
+            std::sort(sub.csr.neighbors.begin() + sub.csr.offsets[i], sub.csr.neighbors.end());
+        }
+
+        for (int v : sub.original_ids) local_id[v] = -1;
+        return sub;
+    }
+
+private:
+    BFSEngine bfs;
+    std::vector<int> local_id;
+};
+
+struct ComponentLabels {
+    std::vector<int> label; // component of each node
+    std::vector<int> sizes;
+};
+
+ComponentLabels ConnectedComponents(const CSRGraph& g, BFSEngine& bfs) {
+    ComponentLabels components;
+    int n = g.numNodes();
+    components.label.assign(n, -1);
+    for (int v = 0; v < n; ++v) {
+        if (components.label[v] >= 0) continue;
+        int id = components.sizes.size();
+        bfs.run(g, v);
+        for (int u : bfs.order()) components.label[u] = id;
+        components.sizes.push_back(bfs.order().size());
+    }
+    return components;
+}
+
+struct BiconnectivityResult {
+    std::vector<char> is_articulation;
+    std::vector<std::pair<int, int>> bridges; // (lower id, higher id), sorted
+    std::vector<int> edge_component;          // biconnected component of each CSR slot, same for both directions
+    int component_count = 0;
+
+    bool isBridge(int u, int v) const {
+        return std::binary_search(bridges.begin(), bridges.end(), std::make_pair(std::min(u, v), std::max(u, v)));
+    }
+};
+
+// Articulation points, bridges and biconnected components of an undirected graph with Tarjan's low-link
+// DFS. The DFS keeps an explicit stack so deep chains cannot overflow the call stack, and connected
+// components are independent, so each one is searched on its own worker.
+BiconnectivityResult ComputeBiconnectivity(const CSRGraph& g) {
+    BiconnectivityResult result;
+    int n = g.numNodes();
+    result.is_articulation.assign(n, 0);
+    result.edge_component.assign(g.neighbors.size(), -1);
+    if (n == 0) return result;
+
+    BFSEngine bfs;
+    ComponentLabels components = ConnectedComponents(g, bfs);
+    std::vector<int> roots(components.sizes.size(), -1);
+    for (int v = n - 1; v >= 0; --v) roots[components.label[v]] = v;
+
+    struct Frame {
+        int node;
+        int next; // next CSR slot to scan
+    };
+    std::vector<int> disc(n, -1), low(n, 0), parent_slot(n, -1);
+    std::vector<int> local_components(roots.size(), 0);
+    std::vector<std::vector<Frame>> frames(WorkerCount());
+    std::vector<std::vector<int>> edge_stacks(WorkerCount());
+    std::vector<std::vector<std::pair<int, int>>> worker_bridges(WorkerCount());
+
+    ParallelFor(0, (int)roots.size(), 1, [&](int begin, int end, int worker) {
+        std::vector<Frame>& stack = frames[worker];
+        std::vector<int>& edge_stack = edge_stacks[worker];
+        for (int c = begin; c < end; ++c) {
+            int root = roots[c];
+            int timer = 0, root_children = 0, bcc = 0;
+            disc[root] = low[root] = timer++;
+            stack.push_back({root, g.offsets[root]});
+            while (!stack.empty()) {
+                int u = stack.back().node;
+                if (stack.back().next < g.offsets[u + 1]) {
+                    int slot = stack.back().next++;
+                    int w = g.neighbors[slot];
+                    if (disc[w] < 0) {
+                        disc[w] = low[w] = timer++;
+                        parent_slot[w] = slot;
+                        edge_stack.push_back(slot);
+                        stack.push_back({w, g.offsets[w]});
+                        if (u == root) root_children++;
+                    } else if (disc[w] < disc[u] && (stack.size() < 2 || w != stack[stack.size() - 2].node)) {
+                        // Back edge to a proper ancestor; the tree edge to the parent is not one
+                        edge_stack.push_back(slot);
+                        low[u] = std::min(low[u], disc[w]);
+                    }
+                    continue;
+                }
+                stack.pop_back();
+                if (stack.empty()) break;
+                int p = stack.back().node;
+                low[p] = std::min(low[p], low[u]);
+                if (low[u] >= disc[p]) {
+                    if (p != root) result.is_articulation[p] = 1;
+                    for (;;) {
+                        int slot = edge_stack.back();
+                        edge_stack.pop_back();
+                        result.edge_component[slot] = bcc;
+                        if (slot == parent_slot[u]) break;
+                    }
+                    bcc++;
+                }
+                if (low[u] > disc[p]) worker_bridges[worker].push_back({std::min(p, u), std::max(p, u)});
+            }
+            if (root_children > 1) result.is_articulation[root] = 1;
+            local_components[c] = bcc;
+        }
+    });
+
+    // Each edge was pushed from exactly one side: number its component globally there, then copy the
+    // label to the reverse slot
+    std::vector<int> first_id(roots.size() + 1, 0);
+    for (size_t c = 0; c < roots.size(); ++c) first_id[c + 1] = first_id[c] + local_components[c];
+    result.component_count = first_id.back();
+    ParallelFor(0, n, 256, [&](int begin, int end, int) {
+        for (int u = begin; u < end; ++u) {
+            for (int slot = g.offsets[u]; slot < g.offsets[u + 1]; ++slot) {
+                if (result.edge_component[slot] >= 0) result.edge_component[slot] += first_id[components.label[u]];
+            }
+        }
+    });
+    ParallelFor(0, n, 256, [&](int begin, int end, int) {
+        for (int u = begin; u < end; ++u) {
+            for (int slot = g.offsets[u]; slot < g.offsets[u + 1]; ++slot) {
+                if (result.edge_component[slot] >= 0) continue;
+                int w = g.neighbors[slot];
+                int reverse = std::lower_bound(g.begin(w), g.end(w), u) - g.neighbors.data();
+                result.edge_component[slot] = result.edge_component[reverse];
+            }
+        }
+    });
+    for (auto& local : worker_bridges) result.bridges.insert(result.bridges.end(), local.begin(), local.end());
+    std::sort(result.bridges.begin(), result.bridges.end());
+    return result;
+}
+
+// Tarjan-Vishkin biconnectivity for graphs whose giant component would leave a single DFS on one thread.
+// A BFS forest stands in for the DFS tree. Preorder numbers and subtree sizes come from a bottom-up and a
+// top-down sweep over the BFS levels, which is what the Euler tour provides in the original. low and high
+// are the extreme preorder numbers reached from a subtree by non-tree links, again collected level by
+// level. Two tree edges share a component when a non-tree link joins their unrelated lower ends, or when the
+// child's subtree reaches outside its parent's, so a concurrent union-find over the tree edges (each named
+// by its lower end) yields the components. A non-tree link joins the component of the tree edge above its
+// later endpoint. Every step is a parallel loop over nodes or over one level.
+BiconnectivityResult ComputeBiconnectivityParallel(const CSRGraph& g) {
+    BiconnectivityResult result;
+    int n = g.numNodes();
+    result.is_articulation.assign(n, 0);
+    result.edge_component.assign(g.neighbors.size(), -1);
+    if (n == 0) return result;
+
+    // Spanning forest: one BFS from the first node of every component
+    BFSEngine bfs;
+    ComponentLabels components = ConnectedComponents(g, bfs);
+    std::vector<int> roots(components.sizes.size(), -1);
+    for (int v = n - 1; v >= 0; --v) roots[components.label[v]] = v;
+    bfs.run(g, g, roots);
+    const std::vector<int>& order = bfs.order();
+    const std::vector<int>& levels = bfs.levelOffsets();
+    std::vector<int> parent(n, -1);
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) {
+            if (bfs.depth(v) == 0) continue;
+            for (const int* w = g.begin(v); w != g.end(v); ++w) {
+                if (bfs.depth(*w) == bfs.depth(v) - 1) {
+                    parent[v] = *w;
+                    break;
+                }
+            }
+        }
+    });
+    std::vector<std::pair<int, int>> tree_links;
+    for (int v = 0; v < n; ++v) {
+        if (parent[v] >= 0) tree_links.push_back({parent[v], v});
+    }
+    CSRGraph children = BuildCSRFromEdges(n, tree_links, false);
+    auto for_each_level = [&](bool bottom_up, const std::function<void(int)>& visit) {
+        for (int l = 0; l < (int)levels.size() - 1; ++l) {
+            int level = bottom_up ? (int)levels.size() - 2 - l : l;
+            ParallelFor(levels[level], levels[level + 1], 256, [&](int begin, int end, int) {
+                for (int i = begin; i < end; ++i) visit(order[i]);
+            });
+        }
+    };
+    auto is_tree_link = [&](int u, int w) { return parent[u] == w || parent[w] == u; };
+
+    // Subtree sizes, then preorder numbers with the roots' trees laid end to end
+    std::vector<int> size(n, 1), pre(n, 0);
+    for_each_level(true, [&](int v) {
+        for (const int* c = children.begin(v); c != children.end(v); ++c) size[v] += size[*c];
+    });
+    for (size_t c = 1; c < roots.size(); ++c) pre[roots[c]] = pre[roots[c - 1]] + size[roots[c - 1]];
+    for_each_level(false, [&](int v) {
+        int next = pre[v] + 1;
+        for (const int* c = children.begin(v); c != children.end(v); ++c) {
+            pre[*c] = next;
+            next += size[*c];
+        }
+    });
+
+    // low and high over each subtree, of the node itself and the far ends of its non-tree links
+    std::vector<int> low(n), high(n);
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) {
+            low[v] = high[v] = pre[v];
+            for (const int* w = g.begin(v); w != g.end(v); ++w) {
+                if (is_tree_link(v, *w)) continue;
+                low[v] = std::min(low[v], pre[*w]);
+                high[v] = std::max(high[v], pre[*w]);
+            }
+        }
+    });
+    for_each_level(true, [&](int v) {
+        for (const int* c = children.begin(v); c != children.end(v); ++c) {
+            low[v] = std::min(low[v], low[*c]);
+            high[v] = std::max(high[v], high[*c]);
+        }
+    });
+
+    // Union-find over tree edges; roots always link to the smaller id, so concurrent unions cannot form cycles
+    std::unique_ptr<std::atomic<int>[]> link(new std::atomic<int>[n]);
+    for (int v = 0; v < n; ++v) link[v].store(v, std::memory_order_relaxed);
+    auto find = [&](int x) {
+        for (;;) {
+            int up = link[x].load(std::memory_order_relaxed);
+            if (up == x) return x;
+            int grand = link[up].load(std::memory_order_relaxed);
+            link[x].compare_exchange_weak(up, grand, std::memory_order_relaxed);
+            x = grand;
+        }
+    };
+    auto unite = [&](int a, int b) {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            int expected = a;
+            if (link[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    };
+    ParallelFor(0, n, 256, [&](int begin, int end, int) {
+        for (int w = begin; w < end; ++w) {
+            int v = parent[w];
+            if (v >= 0 && parent[v] >= 0 && (low[w] < pre[v] || high[w] >= pre[v] + size[v])) unite(w, v);
+            for (const int* u = g.begin(w); u != g.end(w); ++u) {
+                // Each non-tree link once, from its earlier end, when neither end is below the other
+                if (pre[*u] > pre[w] && pre[w] + size[w] <= pre[*u] && !is_tree_link(w, *u)) unite(w, *u);
+            }
+        }
+    });
+
+    // Number the components by their first tree edge in node order
+    std::vector<int> id(n, -1);
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) id[v] = find(v);
+    });
+    std::vector<int> number(n, -1);
+    for (int v = 0; v < n; ++v) {
+        if (parent[v] >= 0 && number[id[v]] < 0) number[id[v]] = result.component_count++;
+    }
+    std::vector<std::vector<std::pair<int, int>>> worker_bridges(WorkerCount());
+    ParallelFor(0, n, 256, [&](int begin, int end, int worker) {
+        for (int u = begin; u < end; ++u) {
+            for (int slot = g.offsets[u]; slot < g.offsets[u + 1]; ++slot) {
+                int w = g.neighbors[slot];
+                int lower = parent[w] == u ? w : parent[u] == w ? u : (pre[w] > pre[u] ? w : u);
+                result.edge_component[slot] = number[id[lower]];
+                if (slot > g.offsets[u] && result.edge_component[slot] != result.edge_component[g.offsets[u]]) {
+                    result.is_articulation[u] = 1;
+                }
+            }
+            // Nothing leaves the subtree but the tree edge above it
+            int p = parent[u];
+            if (p >= 0 && low[u] >= pre[u] && high[u] < pre[u] + size[u]) {
+                worker_bridges[worker].push_back({std::min(p, u), std::max(p, u)});
+            }
+        }
+    });
+    for (auto& local : worker_bridges) result.bridges.insert(result.bridges.end(), local.begin(), local.end());
+    std::sort(result.bridges.begin(), result.bridges.end());
+    return result;
+}
+
+struct SCCResult {
+    std::vector<int> component; // strongly connected component of each node
+    std::vector<int> sizes;
+    CSRGraph condensation;      // the DAG left after collapsing every component to one node
+
+    int count() const { return sizes.size(); }
+    bool inCycle(int v) const { return sizes[component[v]] > 1; }
+};
+
+void BuildCondensation(const CSRGraph& out, SCCResult& scc) {
+    std::vector<std::pair<int, int>> links;
+    for (int u = 0; u < out.numNodes(); ++u) {
+        for (const int* v = out.begin(u); v != out.end(u); ++v) {
+            if (scc.component[u] != scc.component[*v]) links.push_back({scc.component[u], scc.component[*v]});
+        }
+    }
+    scc.condensation = BuildCSRFromEdges(scc.count(), links, false);
+}
+
+// Tarjan's algorithm with an explicit frame stack. Components are numbered in the order they complete,
+// which is a reverse topological order of the condensation.
+SCCResult StronglyConnectedComponents(const CSRGraph& out) {
+    SCCResult scc;
+    int n = out.numNodes();
+    scc.component.assign(n, -1);
+    std::vector<int> index(n, -1), low(n, 0), open;
+    std::vector<char> on_stack(n, 0);
+    std::vector<std::pair<int, int>> frames; // (node, next CSR slot)
+    int counter = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (index[root] >= 0) continue;
+        index[root] = low[root] = counter++;
+        open.push_back(root);
+        on_stack[root] = 1;
+        frames.push_back({root, out.offsets[root]});
+        while (!frames.empty()) {
+            int u = frames.back().first;
+            if (frames.back().second < out.offsets[u + 1]) {
+                int w = out.neighbors[frames.back().second++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    open.push_back(w);
+                    on_stack[w] = 1;
+                    frames.push_back({w, out.offsets[w]});
+                } else if (on_stack[w]) {
+                    low[u] = std::min(low[u], index[w]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (low[u] == index[u]) {
+                int id = scc.sizes.size();
+                int size = 0;
+                int w;
+                do {
+                    w = open.back();
+                    open.pop_back();
+                    on_stack[w] = 0;
+                    scc.component[w] = id;
+                    size++;
+                } while (w != u);
+                scc.sizes.push_back(size);
+            }
+            if (!frames.empty()) {
+                int p = frames.back().first;
+                low[p] = std::min(low[p], low[u]);
+            }
+        }
+    }
+    BuildCondensation(out, scc);
+    return scc;
+}
+
+// Parallel coloring variant (Orzan; Slota et al.) for graphs too large for one DFS. Each round trims
+// nodes with no remaining predecessor or successor, propagates the largest node id forward until it
+// stabilizes, then every node whose color is its own id collects its component with a backward search
+// restricted to its color. Backward searches touch disjoint colors, so they run concurrently.
+SCCResult StronglyConnectedComponentsParallel(const CSRGraph& out, const CSRGraph& in) {
+    int n = out.numNodes();
+    std::vector<int> root_of(n, -1);
+    std::unique_ptr<std::atomic<int>[]> color(new std::atomic<int>[n]);
+    std::vector<int> active(n);
+    for (int v = 0; v < n; ++v) active[v] = v;
+    std::vector<char> trim(n, 0);
+    std::vector<std::vector<int>> stacks(WorkerCount());
+
+    while (!active.empty()) {
+        int count = active.size();
+        ParallelFor(0, count, 1024, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                int v = active[i];
+                bool has_in = false, has_out = false;
+                for (const int* u = in.begin(v); u != in.end(v) && !has_in; ++u) has_in = root_of[*u] < 0 && *u != v;
+                for (const int* w = out.begin(v); w != out.end(v) && !has_out; ++w) has_out = root_of[*w] < 0 && *w != v;
+                trim[v] = !has_in || !has_out;
+                color[v].store(v, std::memory_order_relaxed);
+            }
+        });
+        for (int v : active) {
+            if (trim[v]) root_of[v] = v;
+        }
+
+        std::atomic<bool> changed(true);
+        while (changed.load()) {
+            changed.store(false);
+            ParallelFor(0, count, 1024, [&](int begin, int end, int) {
+                bool local_change = false;
+                for (int i = begin; i < end; ++i) {
+                    int v = active[i];
+                    if (root_of[v] >= 0) continue;
+                    int c = color[v].load(std::memory_order_relaxed);
+                    for (const int* w = out.begin(v); w != out.end(v); ++w) {
+                        if (root_of[*w] >= 0) continue;
+                        int current = color[*w].load(std::memory_order_relaxed);
+                        while (current < c && !color[*w].compare_exchange_weak(current, c, std::memory_order_relaxed)) {
+                        }
+                        if (current < c) local_change = true;
+                    }
+                }
+                if (local_change) changed.store(true);
+            });
+        }
+
+        std::vector<int> roots;
+        for (int v : active) {
+            if (root_of[v] < 0 && color[v].load(std::memory_order_relaxed) == v) roots.push_back(v);
+        }
+        ParallelFor(0, (int)roots.size(), 1, [&](int begin, int end, int worker) {
+            std::vector<int>& stack = stacks[worker];
+            for (int r = begin; r < end; ++r) {
+                int root = roots[r];
+                root_of[root] = root;
+                stack.push_back(root);
+                while (!stack.empty()) {
+                    int u = stack.back();
+                    stack.pop_back();
+                    for (const int* p = in.begin(u); p != in.end(u); ++p) {
+                        // Only this search writes nodes of its color, so check the color before the label
+                        if (color[*p].load(std::memory_order_relaxed) == root && root_of[*p] < 0) {
+                            root_of[*p] = root;
+                            stack.push_back(*p);
+                        }
+                    }
+                }
+            }
+        });
+
+        active.erase(std::remove_if(active.begin(), active.end(), [&](int v) { return root_of[v] >= 0; }), active.end());
+    }
+
+    SCCResult scc;
+    scc.component.assign(n, -1);
+    std::vector<int> id_of_root(n, -1);
+    for (int v = 0; v < n; ++v) {
+        int root = root_of[v];
+        if (id_of_root[root] < 0) {
+            id_of_root[root] = scc.sizes.size();
+            scc.sizes.push_back(0);
+        }
+        scc.component[v] = id_of_root[root];
+        scc.sizes[scc.component[v]]++;
+    }
+    BuildCondensation(out, scc);
+    return scc;
+}
+
+struct TopologicalLevels {
+    std::vector<int> depth;         // length of the longest chain of predecessors, -1 if on a cycle
+    std::vector<int> order;         // nodes level by level
+    std::vector<int> level_offsets; // level l is order[level_offsets[l] .. level_offsets[l + 1])
+    int critical_path = 0;          // edges on the longest dependency chain
+
+    int levels() const { return (int)level_offsets.size() - 1; }
+};
+
+// Level-synchronous Kahn sort. A node becomes ready in the level after its last predecessor, which makes
+// its level exactly its longest-path depth. Each level releases successors in parallel by decrementing
+// atomic in-degree counters; whichever thread brings a counter to zero owns that node.
+TopologicalLevels TopologicalSort(const CSRGraph& dag) {
+    TopologicalLevels levels;
+    int n = dag.numNodes();
+    levels.depth.assign(n, -1);
+    levels.level_offsets.assign(1, 0);
+    std::unique_ptr<std::atomic<int>[]> in_degree(new std::atomic<int>[n]);
+    for (int v = 0; v < n; ++v) in_degree[v].store(0, std::memory_order_relaxed);
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int u = begin; u < end; ++u) {
+            for (const int* v = dag.begin(u); v != dag.end(u); ++v) in_degree[*v].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (int v = 0; v < n; ++v) {
+        if (in_degree[v].load(std::memory_order_relaxed) == 0) {
+            levels.depth[v] = 0;
+            levels.order.push_back(v);
+        }
+    }
+
+    std::vector<std::vector<int>> worker_next(WorkerCount());
+    for (int level = 0; levels.level_offsets.back() < (int)levels.order.size(); ++level) {
+        int level_begin = levels.level_offsets.back();
+        int level_end = levels.order.size();
+        levels.level_offsets.push_back(level_end);
+        ParallelFor(level_begin, level_end, 256, [&](int begin, int end, int worker) {
+            std::vector<int>& next = worker_next[worker];
+            for (int i = begin; i < end; ++i) {
+                int u = levels.order[i];
+                for (const int* v = dag.begin(u); v != dag.end(u); ++v) {
+                    if (in_degree[*v].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        levels.depth[*v] = level + 1;
+                        next.push_back(*v);
+                    }
+                }
+            }
+        });
+        size_t next_begin = levels.order.size();
+        for (auto& local : worker_next) {
+            levels.order.insert(levels.order.end(), local.begin(), local.end());
+            local.clear();
+        }
+        std::sort(levels.order.begin() + next_begin, levels.order.end());
+    }
+    levels.critical_path = std::max(0, levels.levels() - 1);
+    return levels;
+}
+
+// Answers "can a reach b" and "what is reachable from x" over the condensation of a directed graph.
+// Up to kClosureLimit components the whole transitive closure is kept as one bitset row per component,
+// filled deepest level first so each row is the OR of its successors' rows. Larger graphs keep GRAIL
+// interval labels (Yildirim et al.) instead: if v's interval is not nested in u's for every random
+// traversal, u cannot reach v, which rejects most pairs in O(k); the rest fall back to a DFS pruned the
+// same way.
+class ReachabilityIndex {
+public:
+    static constexpr int kClosureLimit = 8192;
+    static constexpr int kLabelCount = 3;
+
+    void build(const SCCResult& scc, const TopologicalLevels& topo, unsigned seed = 1) {
+        component = scc.component;
+        dag = scc.condensation;
+        depth = topo.depth;
+        int count = dag.numNodes();
+        members.offsets.assign(count + 1, 0);
+        for (int c : component) members.offsets[c + 1]++;
+        for (int c = 0; c < count; ++c) members.offsets[c + 1] += members.offsets[c];
+        members.neighbors.resize(component.size());
+        std::vector<int> fill(members.offsets.begin(), members.offsets.end() - 1);
+        for (int v = 0; v < (int)component.size(); ++v) members.neighbors[fill[component[v]]++] = v;
+        stamp.assign(count, 0);
+        current_stamp = 0;
+        closure.clear();
+        labels.clear();
+
+        if (count <= kClosureLimit) {
+            words = (count + 63) / 64;
+            closure.assign((size_t)count * words, 0);
+            for (int level = topo.levels() - 1; level >= 0; --level) {
+                ParallelFor(topo.level_offsets[level], topo.level_offsets[level + 1], 16, [&](int begin, int end, int) {
+                    for (int i = begin; i < end; ++i) {
+                        int c = topo.order[i];
+                        uint64_t* row = &closure[(size_t)c * words];
+                        row[c >> 6] |= uint64_t(1) << (c & 63);
+                        for (const int* d = dag.begin(c); d != dag.end(c); ++d) {
+                            const uint64_t* child = &closure[(size_t)*d * words];
+                            for (int w = 0; w < words; ++w) row[w] |= child[w];
+                        }
+                    }
+                });
+            }
+            return;
+        }
+
+        labels.assign((size_t)count * kLabelCount, Interval());
+        std::vector<int> roots;
+        for (int i = topo.level_offsets[0]; i < topo.level_offsets[1]; ++i) roots.push_back(topo.order[i]);
+        ParallelFor(0, kLabelCount, 1, [&](int begin, int end, int) {
+            for (int k = begin; k < end; ++k) labelTraversal(k, roots, seed + k);
+        });
+    }
+
+    bool usesClosure() const { return !closure.empty(); }
+
+    bool canReach(int from, int to) {
+        int a = component[from], b = component[to];
+        if (a == b) return true;
+        if (usesClosure()) return closure[(size_t)a * words + (b >> 6)] & (uint64_t(1) << (b & 63));
+        if (!mayReach(a, b)) return false;
+        nextStamp();
+        std::vector<int>& stack = scratch;
+        stack.assign(1, a);
+        stamp[a] = current_stamp;
+        while (!stack.empty()) {
+            int c = stack.back();
+            stack.pop_back();
+            for (const int* d = dag.begin(c); d != dag.end(c); ++d) {
+                if (*d == b) return true;
+                if (stamp[*d] == current_stamp || !mayReach(*d, b)) continue;
+                stamp[*d] = current_stamp;
+                stack.push_back(*d);
+            }
+        }
+        return false;
+    }
+
+    // Every node `from` can reach, other than itself
+    std::vector<int> reachableFrom(int from) {
+        std::vector<int> result;
+        int a = component[from];
+        auto add_members = [&](int c) {
+            for (const int* v = members.begin(c); v != members.end(c); ++v) {
+                if (*v != from) result.push_back(*v);
+            }
+        };
+        if (usesClosure()) {
+            const uint64_t* row = &closure[(size_t)a * words];
+            for (int w = 0; w < words; ++w) {
+                for (uint64_t bits = row[w]; bits; bits &= bits - 1) add_members(w * 64 + LowestSetBit(bits));
+            }
+            return result;
+        }
+        nextStamp();
+        std::vector<int>& stack = scratch;
+        stack.assign(1, a);
+        stamp[a] = current_stamp;
+        while (!stack.empty()) {
+            int c = stack.back();
+            stack.pop_back();
+            add_members(c);
+            for (const int* d = dag.begin(c); d != dag.end(c); ++d) {
+                if (stamp[*d] == current_stamp) continue;
+                stamp[*d] = current_stamp;
+                stack.push_back(*d);
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Interval {
+        int low = 0, post = 0;
+    };
+
+    std::vector<int> component;
+    CSRGraph members; // nodes of each component
+    CSRGraph dag;
+    std::vector<int> depth;
+    int words = 0;
+    std::vector<uint64_t> closure;
+    std::vector<Interval> labels; // kLabelCount per component
+    std::vector<unsigned> stamp;
+    unsigned current_stamp = 0;
+    std::vector<int> scratch;
+
+    void nextStamp() {
+        if (++current_stamp == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            current_stamp = 1;
+        }
+    }
+
+    // False means a certainly cannot reach b
+    bool mayReach(int a, int b) const {
+        if (depth[a] >= depth[b]) return false;
+        for (int k = 0; k < kLabelCount; ++k) {
+            const Interval& la = labels[(size_t)a * kLabelCount + k];
+            const Interval& lb = labels[(size_t)b * kLabelCount + k];
+            if (lb.low < la.low || lb.post > la.post) return false;
+        }
+        return true;
+    }
+
+    // Post-order DFS that visits children starting at a random offset; low is the smallest rank below a node
+    void labelTraversal(int k, std::vector<int> roots, unsigned seed) {
+        Pcg32 rng(seed);
+        for (int i = (int)roots.size() - 1; i > 0; --i) std::swap(roots[i], roots[rng.below(i + 1)]);
+        int count = dag.numNodes();
+        std::vector<char> done(count, 0);
+        struct Frame {
+            int node, start, scanned;
+        };
+        std::vector<Frame> frames;
+        int rank = 0;
+        for (int root : roots) {
+            if (done[root]) continue;
+            done[root] = 1;
+            labels[(size_t)root * kLabelCount + k].low = std::numeric_limits<int>::max();
+            frames.push_back({root, dag.degree(root) ? (int)rng.below(dag.degree(root)) : 0, 0});
+            while (!frames.empty()) {
+                Frame& f = frames.back();
+                Interval& label = labels[(size_t)f.node * kLabelCount + k];
+                if (f.scanned < dag.degree(f.node)) {
+                    int child = dag.neighbors[dag.offsets[f.node] + (f.start + f.scanned) % dag.degree(f.node)];
+                    f.scanned++;
+                    if (done[child]) {
+                        label.low = std::min(label.low, labels[(size_t)child * kLabelCount + k].low);
+                        continue;
+                    }
+                    done[child] = 1;
+                    labels[(size_t)child * kLabelCount + k].low = std::numeric_limits<int>::max();
+                    frames.push_back({child, dag.degree(child) ? (int)rng.below(dag.degree(child)) : 0, 0});
+                    continue;
+                }
+                label.post = rank++;
+                label.low = std::min(label.low, label.post);
+                int finished = f.node;
+                frames.pop_back();
+                if (!frames.empty()) {
+                    Interval& parent = labels[(size_t)frames.back().node * kLabelCount + k];
+                    parent.low = std::min(parent.low, labels[(size_t)finished * kLabelCount + k].low);
+                }
+            }
+        }
+    }
+};
+
+// PageRank on an undirected CSR with the same update as GraphVisualizer::calculatePageRank, iterated to
+// convergence from `rank` instead of from a uniform vector. After a small change to the graph the old
+// ranks are already close, so only a handful of iterations are needed. Removed nodes keep rank 0 and
+// removed slots (both directions of a link) stop carrying rank.
+std::vector<float> PageRankWarmStart(const CSRGraph& g, std::vector<float> rank, const BFSFilter& filter,
+                                     float damping_factor = 0.85f, float tolerance = 1e-5f,
+                                     int max_iterations = 100, int* iterations_run = nullptr) {
+    int n = g.numNodes();
+    rank.resize(n, 1.0f - damping_factor);
+    std::vector<float> share(n, 0.0f), next(n, 0.0f);
+    std::vector<int> degree(n, 0);
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int u = begin; u < end; ++u) {
+            if (filter.blocksNode(u)) continue;
+            for (int slot = g.offsets[u]; slot < g.offsets[u + 1]; ++slot) {
+                if (!filter.blocksSlot(slot) && !filter.blocksNode(g.neighbors[slot])) degree[u]++;
+            }
+        }
+    });
+
+    int iteration = 0;
+    std::vector<float> worker_delta(WorkerCount());
+    for (; iteration < max_iterations; ++iteration) {
+        for (int u = 0; u < n; ++u) share[u] = degree[u] > 0 ? rank[u] / degree[u] : 0.0f;
+        std::fill(worker_delta.begin(), worker_delta.end(), 0.0f);
+        ParallelFor(0, n, 1024, [&](int begin, int end, int worker) {
+            float delta = 0.0f;
+            for (int v = begin; v < end; ++v) {
+                if (filter.blocksNode(v)) {
+                    next[v] = 0.0f;
+                    continue;
+                }
+                float sum = 0.0f;
+                for (int slot = g.offsets[v]; slot < g.offsets[v + 1]; ++slot) {
+                    if (!filter.blocksSlot(slot)) sum += share[g.neighbors[slot]];
+                }
+                next[v] = (1.0f - damping_factor) + damping_factor * sum;
+                delta = std::max(delta, std::fabs(next[v] - rank[v]));
+            }
+            worker_delta[worker] = std::max(worker_delta[worker], delta);
+        });
+        rank.swap(next);
+        if (*std::max_element(worker_delta.begin(), worker_delta.end()) < tolerance) {
+            iteration++;
+            break;
+        }
+    }
+    if (iterations_run) *iterations_run = iteration;
+    return rank;
+}
+
+// Degeneracy ordering by repeatedly removing a minimum-degree node (Matula & Beck, bucket queue, O(n + m))
+std::vector<int> DegeneracyOrder(const CSRGraph& g, int* degeneracy = nullptr) {
+    int n = g.numNodes();
+    int max_degree = 0;
+    std::vector<int> degree(n);
+    for (int v = 0; v < n; ++v) {
+        degree[v] = g.degree(v);
+        max_degree = std::max(max_degree, degree[v]);
+    }
+    std::vector<int> bucket_start(max_degree + 2, 0), position(n), sorted(n);
+    for (int v = 0; v < n; ++v) bucket_start[degree[v] + 1]++;
+    for (int d = 0; d <= max_degree; ++d) bucket_start[d + 1] += bucket_start[d];
+    std::vector<int> fill(bucket_start.begin(), bucket_start.end() - 1);
+    for (int v = 0; v < n; ++v) {
+        position[v] = fill[degree[v]]++;
+        sorted[position[v]] = v;
+    }
+    int core = 0;
+    for (int i = 0; i < n; ++i) {
+        int v = sorted[i];
+        core = std::max(core, degree[v]);
+        for (const int* u = g.begin(v); u != g.end(v); ++u) {
+            if (position[*u] <= i || degree[*u] <= degree[v]) continue;
+            // Move u to the front of its bucket, then shrink the bucket by one
+            int du = degree[*u];
+            int front = std::max(bucket_start[du], i + 1);
+            int w = sorted[front];
+            std::swap(sorted[front], sorted[position[*u]]);
+            position[w] = position[*u];
+            position[*u] = front;
+            bucket_start[du] = front + 1;
+            degree[*u]--;
+        }
+    }
+    if (degeneracy) *degeneracy = core;
+    return sorted;
+}
+
+// Bron-Kerbosch with Tomita pivoting, started once per node in degeneracy order (Eppstein, Loeffler &
+// Strash): the top-level call for v only considers neighbors later in the order as candidates, which
+// keeps every candidate set within the degeneracy and makes the top-level calls independent, so they
+// are spread over the workers. Cliques of at least min_size are passed to emit as they are found, one
+// at a time. Returns false if the time budget ran out first.
+template <typename Emit>
+bool EnumerateMaximalCliques(const CSRGraph& g, int min_size, double time_budget_ms, Emit emit) {
+    int n = g.numNodes();
+    std::vector<int> order = DegeneracyOrder(g);
+    std::vector<int> rank(n);
+    for (int i = 0; i < n; ++i) rank[order[i]] = i;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(time_budget_ms * 1000.0));
+    std::atomic<bool> out_of_time(false);
+    std::mutex emit_mutex;
+
+    auto intersect = [&](const std::vector<int>& set, int v) {
+        std::vector<int> result;
+        std::set_intersection(set.begin(), set.end(), g.begin(v), g.end(v), std::back_inserter(result));
+        return result;
+    };
+
+    // Candidate and excluded sets are small sorted vectors; recursion depth is bounded by the clique size
+    std::function<void(std::vector<int>&, std::vector<int>, std::vector<int>)> expand =
+        [&](std::vector<int>& clique, std::vector<int> candidates, std::vector<int> excluded) {
+            if (out_of_time.load(std::memory_order_relaxed)) return;
+            if (std::chrono::steady_clock::now() > deadline) {
+                out_of_time.store(true);
+                return;
+            }
+            if (candidates.empty()) {
+                if (excluded.empty() && (int)clique.size() >= min_size) {
+                    std::lock_guard<std::mutex> lock(emit_mutex);
+                    emit(clique);
+                }
+                return;
+            }
+            if ((int)(clique.size() + candidates.size()) < min_size) return;
+
+            // Pivot on the node covering the most candidates; only its non-neighbors need a branch
+            int pivot = -1, best = -1;
+            for (const std::vector<int>* set : {&candidates, &excluded}) {
+                for (int u : *set) {
+                    int covered = IntersectCount(candidates.data(), candidates.size(), g.begin(u), g.degree(u));
+                    if (covered > best) {
+                        best = covered;
+                        pivot = u;
+                    }
+                }
+            }
+            std::vector<int> branches;
+            std::set_difference(candidates.begin(), candidates.end(), g.begin(pivot), g.end(pivot), std::back_inserter(branches));
+            for (int v : branches) {
+                clique.push_back(v);
+                expand(clique, intersect(candidates, v), intersect(excluded, v));
+                clique.pop_back();
+                candidates.erase(std::lower_bound(candidates.begin(), candidates.end(), v));
+                excluded.insert(std::lower_bound(excluded.begin(), excluded.end(), v), v);
+            }
+        };
+
+    ParallelFor(0, n, 1, [&](int begin, int end, int) {
+        for (int i = begin; i < end; ++i) {
+            int v = order[i];
+            std::vector<int> candidates, excluded, clique{v};
+            for (const int* u = g.begin(v); u != g.end(v); ++u) {
+                (rank[*u] > i ? candidates : excluded).push_back(*u);
+            }
+            expand(clique, candidates, excluded);
+        }
+    });
+    return !out_of_time.load();
+}
+
+// All-pairs SimRank with Lizorkin et al.'s partial sums: the sums over a's neighbors are memoized per
+// column, so each iteration costs O(n^2 d) instead of O(n^2 d^2). Neighborhoods are the undirected ones,
+// since the direction of a triple says little about structural role. Rows are computed in parallel.
+// Returns the row-major n x n matrix; only meant for graphs of a few thousand nodes.
+std::vector<float> SimRankExact(const CSRGraph& g, float decay = 0.8f, int iterations = 5) {
+    int n = g.numNodes();
+    std::vector<float> sim((size_t)n * n, 0.0f), next((size_t)n * n, 0.0f), partial((size_t)n * n, 0.0f);
+    for (int a = 0; a < n; ++a) sim[(size_t)a * n + a] = 1.0f;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        // partial[a][j] = sum over i in N(a) of sim[i][j]
+        ParallelFor(0, n, 16, [&](int begin, int end, int) {
+            for (int a = begin; a < end; ++a) {
+                float* row = &partial[(size_t)a * n];
+                std::fill(row, row + n, 0.0f);
+                for (const int* i = g.begin(a); i != g.end(a); ++i) {
+                    const float* source = &sim[(size_t)*i * n];
+                    for (int j = 0; j < n; ++j) row[j] += source[j];
+                }
+            }
+        });
+        ParallelFor(0, n, 16, [&](int begin, int end, int) {
+            for (int a = begin; a < end; ++a) {
+                const float* row = &partial[(size_t)a * n];
+                float* out = &next[(size_t)a * n];
+                for (int b = 0; b < n; ++b) {
+                    if (a == b) {
+                        out[b] = 1.0f;
+                        continue;
+                    }
+                    if (g.degree(a) == 0 || g.degree(b) == 0) {
+                        out[b] = 0.0f;
+                        continue;
+                    }
+                    float sum = 0.0f;
+                    for (const int* j = g.begin(b); j != g.end(b); ++j) sum += row[*j];
+                    out[b] = decay * sum / (float(g.degree(a)) * g.degree(b));
+                }
+            }
+        });
+        sim.swap(next);
+    }
+    return sim;
+}
+
+// Single-source SimRank by Monte Carlo (Fogaras & Racz): s(u, v) is the expected decay^t of the first step
+// t at which random walks from u and from v meet. The walks from the source are sampled once and shared;
+// every other node's walks are independent, so nodes are split over the workers. Seeded per node, so the
+// result does not depend on the thread count.
+std::vector<float> SimRankSingleSource(const CSRGraph& g, int source, float decay = 0.8f, int walks = 200,
+                                       int length = 10, unsigned seed = 1) {
+    int n = g.numNodes();
+    std::vector<float> sim(n, 0.0f);
+    if (source < 0 || source >= n) return sim;
+    // source_paths[w * (length + 1) + t] is the position of walk w after t steps, -1 once it is stuck
+    std::vector<int> source_paths((size_t)walks * (length + 1), -1);
+    Pcg32 source_rng(seed);
+    for (int w = 0; w < walks; ++w) {
+        int at = source;
+        for (int t = 0; t <= length && at >= 0; ++t) {
+            source_paths[(size_t)w * (length + 1) + t] = at;
+            at = g.degree(at) ? g.begin(at)[source_rng.below(g.degree(at))] : -1;
+        }
+    }
+    ParallelFor(0, n, 64, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) {
+            if (v == source) {
+                sim[v] = 1.0f;
+                continue;
+            }
+            Pcg32 rng(seed, v + 1);
+            double total = 0.0;
+            for (int w = 0; w < walks; ++w) {
+                const int* path = &source_paths[(size_t)w * (length + 1)];
+                int at = v;
+                float weight = 1.0f;
+                for (int t = 1; t <= length; ++t) {
+                    if (g.degree(at) == 0 || path[t] < 0) break;
+                    at = g.begin(at)[rng.below(g.degree(at))];
+                    weight *= decay;
+                    if (at == path[t]) {
+                        total += weight;
+                        break;
+                    }
+                }
+            }
+            sim[v] = float(total / walks);
+        }
+    });
+    return sim;
+}
+
+#if defined(GRAPH_HAS_AVX512_KERNELS)
+// AccumulateRepulsion's kernel over blocks of 16 from i on; adds the unscaled sums and returns where it stopped
+GRAPH_TARGET("avx512f") int RepulsionBlocksAVX512(float x, float y, const float* xs, const float* ys, int i, int end,
+                                                  float& sum_x, float& sum_y) {
+    // The zero-masking forms and the lane sums below stand in for _mm512_max_ps, _mm512_rsqrt14_ps and
+    // _mm512_reduce_add_ps, whose undefined placeholder operand GCC 12 reports as uninitialized under -Wall
+    const __mmask16 all = 0xffff;
+    const __m512 px = _mm512_set1_ps(x), py = _mm512_set1_ps(y);
+    const __m512 one = _mm512_set1_ps(1.0f), half = _mm512_set1_ps(0.5f), three_halves = _mm512_set1_ps(1.5f);
+    __m512 acc_x = _mm512_setzero_ps(), acc_y = _mm512_setzero_ps();
+    for (; i + 16 <= end; i += 16) {
+        __m512 dx = _mm512_sub_ps(px, _mm512_loadu_ps(xs + i));
+        __m512 dy = _mm512_sub_ps(py, _mm512_loadu_ps(ys + i));
+        __m512 dist_sq = _mm512_maskz_max_ps(all, _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy)), one);
+        __m512 r = _mm512_maskz_rsqrt14_ps(all, dist_sq);
+        r = _mm512_mul_ps(r, _mm512_fnmadd_ps(_mm512_mul_ps(half, dist_sq), _mm512_mul_ps(r, r), three_halves));
+        __m512 scale = _mm512_mul_ps(_mm512_mul_ps(r, r), r);
+        acc_x = _mm512_fmadd_ps(dx, scale, acc_x);
+        acc_y = _mm512_fmadd_ps(dy, scale, acc_y);
+    }
+    // Pairwise in the order of GCC's _mm512_reduce_add_ps, so the sums come out as they did with it
+    alignas(64) float lanes[2][16];
+    _mm512_store_ps(lanes[0], acc_x);
+    _mm512_store_ps(lanes[1], acc_y);
+    float sums[2];
+    for (int a = 0; a < 2; ++a) {
+        float quarter[4];
+        for (int l = 0; l < 4; ++l) quarter[l] = (lanes[a][l + 12] + lanes[a][l + 4]) + (lanes[a][l + 8] + lanes[a][l]);
+        sums[a] = (quarter[0] + quarter[2]) + (quarter[1] + quarter[3]);
+    }
+    sum_x += sums[0];
+    sum_y += sums[1];
+    return i;
+}
+#endif
+
+#if defined(GRAPH_HAS_AVX2_KERNELS)
+// The same over blocks of 8
+GRAPH_TARGET("avx2") int RepulsionBlocksAVX2(float x, float y, const float* xs, const float* ys, int i, int end,
+                                             float& sum_x, float& sum_y) {
+    const __m256 px8 = _mm256_set1_ps(x), py8 = _mm256_set1_ps(y);
+    const __m256 one8 = _mm256_set1_ps(1.0f), half8 = _mm256_set1_ps(0.5f), three_halves8 = _mm256_set1_ps(1.5f);
+    __m256 acc_x8 = _mm256_setzero_ps(), acc_y8 = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+        __m256 dx = _mm256_sub_ps(px8, _mm256_loadu_ps(xs + i));
+        __m256 dy = _mm256_sub_ps(py8, _mm256_loadu_ps(ys + i));
+        __m256 dist_sq = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), one8);
+        __m256 r = _mm256_rsqrt_ps(dist_sq);
+        r = _mm256_mul_ps(r, _mm256_sub_ps(three_halves8, _mm256_mul_ps(_mm256_mul_ps(half8, dist_sq), _mm256_mul_ps(r, r))));
+        __m256 scale = _mm256_mul_ps(_mm256_mul_ps(r, r), r);
+        acc_x8 = _mm256_add_ps(acc_x8, _mm256_mul_ps(dx, scale));
+        acc_y8 = _mm256_add_ps(acc_y8, _mm256_mul_ps(dy, scale));
+    }
+    alignas(32) float lanes_x[8], lanes_y[8];
+    _mm256_store_ps(lanes_x, acc_x8);
+    _mm256_store_ps(lanes_y, acc_y8);
+    for (int l = 0; l < 8; ++l) {
+        sum_x += lanes_x[l];
+        sum_y += lanes_y[l];
+    }
+    return i;
+}
+#endif
+
+// Adds the inverse-square push that points [begin, end) of the SoA arrays exert on (x, y): strength * d / |d|^3,
+// with |d|^2 clamped to 1. A point on top of (x, y), the query itself included, contributes nothing. The vector
+// paths use rsqrt with one Newton step (about 1e-7 relative error) and handle 16 or 8 pairs per iteration.
+void AccumulateRepulsion(float x, float y, const float* xs, const float* ys, int begin, int end, float strength,
+                         float& fx, float& fy) {
+    int i = begin;
+    float sum_x = 0.0f, sum_y = 0.0f;
+#if defined(GRAPH_HAS_AVX512_KERNELS)
+    if (CpuHasAVX512()) i = RepulsionBlocksAVX512(x, y, xs, ys, i, end, sum_x, sum_y);
+#endif
+#if defined(GRAPH_HAS_AVX2_KERNELS)
+    if (CpuHasAVX2()) i = RepulsionBlocksAVX2(x, y, xs, ys, i, end, sum_x, sum_y);
+#endif
+    for (; i < end; ++i) {
+        float dx = x - xs[i], dy = y - ys[i];
+        float dist_sq = dx * dx + dy * dy;
+        if (dist_sq < 1.0f) dist_sq = 1.0f;
+        float dist = sqrtf(dist_sq);
+        float scale = 1.0f / (dist_sq * dist);
+        sum_x += dx * scale;
+        sum_y += dy * scale;
+    }
+    fx += sum_x * strength;
+    fy += sum_y * strength;
+}
+
+// Barnes-Hut quadtree over a point set. Points are reordered so every cell covers a contiguous range of
+// them, and leaves keep up to kLeafSize points that are summed directly. Rebuilt from scratch each step.
+class QuadTree {
+public:
+    static constexpr int kLeafSize = 8;
+    static constexpr int kMaxDepth = 24; // stops splitting piles of coincident points
+
+    void build(const std::vector<float>& xs, const std::vector<float>& ys) {
+        int n = xs.size();
+        cells.clear();
+        order.resize(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        if (n == 0) return;
+
+        float min_x = xs[0], max_x = xs[0], min_y = ys[0], max_y = ys[0];
+        for (int i = 1; i < n; ++i) {
+            min_x = std::min(min_x, xs[i]);
+            max_x = std::max(max_x, xs[i]);
+            min_y = std::min(min_y, ys[i]);
+            max_y = std::max(max_y, ys[i]);
+        }
+        Cell root;
+        root.cx = 0.5f * (min_x + max_x);
+        root.cy = 0.5f * (min_y + max_y);
+        root.half = 0.5f * std::max(max_x - min_x, max_y - min_y) + 1.0f;
+        root.begin = 0;
+        root.end = n;
+        cells.push_back(root);
+
+        std::vector<std::pair<int, int>> pending = {{0, 0}}; // (cell, depth)
+        while (!pending.empty()) {
+            int c = pending.back().first;
+            int depth = pending.back().second;
+            pending.pop_back();
+            if (cells[c].end - cells[c].begin <= kLeafSize || depth >= kMaxDepth) continue;
+
+            Cell parent = cells[c];
+            auto first = order.begin() + parent.begin;
+            auto last = order.begin() + parent.end;
+            auto split_y = std::partition(first, last, [&](int i) { return ys[i] < parent.cy; });
+            auto split_top = std::partition(first, split_y, [&](int i) { return xs[i] < parent.cx; });
+            auto split_bottom = std::partition(split_y, last, [&](int i) { return xs[i] < parent.cx; });
+            int bounds[5] = {parent.begin, (int)(split_top - order.begin()), (int)(split_y - order.begin()),
+                             (int)(split_bottom - order.begin()), parent.end};
+
+            cells[c].first_child = cells.size();
+            for (int q = 0; q < 4; ++q) {
+                Cell child;
+                child.half = 0.5f * parent.half;
+                child.cx = parent.cx + ((q & 1) ? child.half : -child.half);
+                child.cy = parent.cy + ((q & 2) ? child.half : -child.half);
+                child.begin = bounds[q];
+                child.end = bounds[q + 1];
+                cells.push_back(child);
+                if (child.end > child.begin) pending.push_back({(int)cells.size() - 1, depth + 1});
+            }
+        }
+
+        sorted_x.resize(n);
+        sorted_y.resize(n);
+        for (int i = 0; i < n; ++i) {
+            sorted_x[i] = xs[order[i]];
+            sorted_y[i] = ys[order[i]];
+        }
+        // Children always come after their parent, so a reverse sweep sees them first
+        for (int c = (int)cells.size() - 1; c >= 0; --c) {
+            Cell& cell = cells[c];
+            cell.mass = float(cell.end - cell.begin);
+            cell.mx = cell.my = 0.0f;
+            if (cell.first_child < 0) {
+                for (int i = cell.begin; i < cell.end; ++i) {
+                    cell.mx += sorted_x[i];
+                    cell.my += sorted_y[i];
+                }
+            } else {
+                for (int q = 0; q < 4; ++q) {
+                    const Cell& child = cells[cell.first_child + q];
+                    cell.mx += child.mx * child.mass;
+                    cell.my += child.my * child.mass;
+                }
+            }
+            if (cell.mass > 0.0f) {
+                cell.mx /= cell.mass;
+                cell.my /= cell.mass;
+            }
+        }
+    }
+
+    // Adds the repulsion every point in the tree exerts on (x, y), with the same inverse-square law as the
+    // exact kernel. A cell whose width over its distance is below theta acts as one body at its center of mass,
+    // unless (x, y) lies inside it: with theta above 1/sqrt(2) that test can pass for the cell holding the
+    // point itself, which would then be pushed by a share of its own mass.
+    void accumulateRepulsion(float x, float y, float strength, float theta, float& fx, float& fy) const {
+        if (cells.empty()) return;
+        int stack[4 * kMaxDepth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        float theta_sq = theta * theta;
+        while (top > 0) {
+            const Cell& cell = cells[stack[--top]];
+            if (cell.first_child < 0) {
+                AccumulateRepulsion(x, y, sorted_x.data(), sorted_y.data(), cell.begin, cell.end, strength, fx, fy);
+                continue;
+            }
+            float dx = x - cell.mx, dy = y - cell.my;
+            float width = 2.0f * cell.half;
+            bool inside = std::fabs(x - cell.cx) <= cell.half && std::fabs(y - cell.cy) <= cell.half;
+            if (!inside && width * width < theta_sq * (dx * dx + dy * dy)) {
+                addRepulsion(dx, dy, strength * cell.mass, fx, fy);
+                continue;
+            }
+            for (int q = 0; q < 4; ++q) {
+                const Cell& child = cells[cell.first_child + q];
+                if (child.end > child.begin) stack[top++] = cell.first_child + q;
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        float cx = 0, cy = 0, half = 0; // bounding square
+        float mass = 0, mx = 0, my = 0; // point count and center of mass
+        int begin = 0, end = 0;         // range in tree order
+        int first_child = -1;           // four consecutive cells, -1 for a leaf
+    };
+
+    std::vector<Cell> cells;
+    std::vector<int> order; // original point index in tree order
+    std::vector<float> sorted_x, sorted_y;
+
+    static void addRepulsion(float dx, float dy, float strength, float& fx, float& fy) {
+        float dist_sq = dx * dx + dy * dy;
+        if (dist_sq < 1.0f) dist_sq = 1.0f;
+        float dist = sqrtf(dist_sq);
+        float force = strength / dist_sq;
+        fx += dx / dist * force;
+        fy += dy / dist * force;
+    }
+};
+
+// Uniform grid for cutoff repulsion. Points are bucketed into square cells no smaller than the cutoff with a
+// stable parallel counting sort, so each cell is a contiguous range and a row of three neighboring cells is
+// one range as well. A query only visits the 3x3 block around its own cell, which covers the cutoff radius.
+class UniformGrid {
+public:
+    void build(const std::vector<float>& xs, const std::vector<float>& ys, float cutoff) {
+        int n = xs.size();
+        order.resize(n);
+        sorted_x.resize(n);
+        sorted_y.resize(n);
+        cols = rows = 0;
+        if (n == 0) return;
+
+        min_x = xs[0];
+        min_y = ys[0];
+        float max_x = xs[0], max_y = ys[0];
+        for (int i = 1; i < n; ++i) {
+            min_x = std::min(min_x, xs[i]);
+            max_x = std::max(max_x, xs[i]);
+            min_y = std::min(min_y, ys[i]);
+            max_y = std::max(max_y, ys[i]);
+        }
+        // Widely scattered points would need far more cells than points; grow the cells instead. The size solves
+        // (width / s + 1) * (height / s + 1) = 2n, which keeps it to about 2n cells even for a long thin drawing.
+        double width = max_x - min_x + 1.0, height = max_y - min_y + 1.0, k = 2.0 * n - 1.0;
+        double span = width + height;
+        cell_size = std::max(cutoff, float((span + sqrt(span * span + 4.0 * k * width * height)) / (2.0 * k)));
+        cols = (int)(width / cell_size) + 1;
+        rows = (int)(height / cell_size) + 1;
+        int cells = cols * rows;
+
+        cell_of.resize(n);
+        ParallelFor(0, n, 4096, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) cell_of[i] = cellIndex(xs[i], ys[i]);
+        });
+
+        // Counting sort over fixed chunks of the input: histogram per chunk, exclusive scan in (cell, chunk)
+        // order, then each chunk scatters its points. Stable, so the result does not depend on the workers.
+        const int chunk_size = 16384;
+        int chunks = (n + chunk_size - 1) / chunk_size;
+        counts.assign((size_t)chunks * cells, 0);
+        ParallelFor(0, chunks, 1, [&](int begin, int end, int) {
+            for (int c = begin; c < end; ++c) {
+                int* histogram = counts.data() + (size_t)c * cells;
+                for (int i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); ++i) histogram[cell_of[i]]++;
+            }
+        });
+        cell_start.resize(cells + 1);
+        int total = 0;
+        for (int cell = 0; cell < cells; ++cell) {
+            cell_start[cell] = total;
+            for (int c = 0; c < chunks; ++c) {
+                int count = counts[(size_t)c * cells + cell];
+                counts[(size_t)c * cells + cell] = total;
+                total += count;
+            }
+        }
+        cell_start[cells] = total;
+        ParallelFor(0, chunks, 1, [&](int begin, int end, int) {
+            for (int c = begin; c < end; ++c) {
+                int* next = counts.data() + (size_t)c * cells;
+                for (int i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); ++i) {
+                    int slot = next[cell_of[i]]++;
+                    order[slot] = i;
+                    sorted_x[slot] = xs[i];
+                    sorted_y[slot] = ys[i];
+                }
+            }
+        });
+    }
+
+    // Input indices grouped by cell; iterating queries in this order keeps neighbors in cache
+    const std::vector<int>& pointOrder() const { return order; }
+
+    // Adds the repulsion of every point in the 3x3 cells around (x, y), including the point itself (a no-op)
+    void accumulateRepulsion(float x, float y, float strength, float& fx, float& fy) const {
+        if (cols == 0) return;
+        int cell = cellIndex(x, y);
+        int col = cell % cols, row = cell / cols;
+        int first_col = std::max(col - 1, 0), last_col = std::min(col + 1, cols - 1);
+        for (int r = std::max(row - 1, 0); r <= std::min(row + 1, rows - 1); ++r) {
+            int begin = cell_start[r * cols + first_col], end = cell_start[r * cols + last_col + 1];
+            AccumulateRepulsion(x, y, sorted_x.data(), sorted_y.data(), begin, end, strength, fx, fy);
+        }
+    }
+
+private:
+    float min_x = 0, min_y = 0, cell_size = 1;
+    int cols = 0, rows = 0;
+    std::vector<int> cell_of;    // per input point
+    std::vector<int> counts;     // per chunk and cell, then the chunk's next output slot
+    std::vector<int> cell_start; // cells + 1 offsets into the sorted arrays
+    std::vector<int> order;      // input index of each sorted point
+    std::vector<float> sorted_x, sorted_y;
+
+    int cellIndex(float x, float y) const {
+        int col = std::min(cols - 1, std::max(0, (int)((x - min_x) / cell_size)));
+        int row = std::min(rows - 1, std::max(0, (int)((y - min_y) / cell_size)));
+        return row * cols + col;
+    }
+};
+
+// Pivot MDS (Brandes and Pich, "Eigensolver methods for progressive multidimensional scaling of large data")
+// of one connected graph, in units of mean edge length. BFS distances from k pivots, picked one at a time as
+// the node farthest from all earlier ones, are squared and double-centered into an n x k matrix C. The two
+// leading eigenvectors of the small k x k matrix C^T C, found by power iteration, project C onto the plane.
+// Costs k searches plus O(nk^2) arithmetic.
+std::vector<ImVec2> PivotMDSComponent(const CSRGraph& g, BFSEngine& bfs, int pivot_count) {
+    int n = g.numNodes();
+    std::vector<ImVec2> coords(n, ImVec2(0.0f, 0.0f));
+    int k = std::min(pivot_count, n);
+    if (n == 2) coords[1].x = 1.0f;
+    if (k < 3) return coords;
+
+    std::vector<float> c((size_t)n * k); // column p: squared hop distances from pivot p
+    std::vector<int> nearest_pivot_hops(n, std::numeric_limits<int>::max());
+    int pivot = 0;
+    for (int v = 1; v < n; ++v) {
+        if (g.degree(v) > g.degree(pivot)) pivot = v;
+    }
+    for (int p = 0; p < k; ++p) {
+        bfs.run(g, pivot);
+        int next = 0;
+        for (int v = 0; v < n; ++v) {
+            int hops = bfs.depth(v);
+            c[(size_t)v * k + p] = float(hops) * hops;
+            nearest_pivot_hops[v] = std::min(nearest_pivot_hops[v], hops);
+            if (nearest_pivot_hops[v] > nearest_pivot_hops[next]) next = v;
+        }
+        pivot = next;
+    }
+
+    // Double centering: C = -1/2 (D^2 - row means - column means + grand mean)
+    std::vector<double> column_mean(k, 0.0);
+    for (int v = 0; v < n; ++v) {
+        for (int p = 0; p < k; ++p) column_mean[p] += c[(size_t)v * k + p];
+    }
+    double grand_mean = 0.0;
+    for (int p = 0; p < k; ++p) {
+        column_mean[p] /= n;
+        grand_mean += column_mean[p] / k;
+    }
+    ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+        for (int v = begin; v < end; ++v) {
+            float* row = c.data() + (size_t)v * k;
+            double row_mean = 0.0;
+            for (int p = 0; p < k; ++p) row_mean += row[p];
+            row_mean /= k;
+            for (int p = 0; p < k; ++p) row[p] = float(-0.5 * (row[p] - row_mean - column_mean[p] + grand_mean));
+        }
+    });
+
+    // C^T C, then its two leading eigenvectors by power iteration, the second kept orthogonal to the first
+    std::vector<double> ctc((size_t)k * k, 0.0);
+    ParallelFor(0, k, 1, [&](int begin, int end, int) {
+        for (int a = begin; a < end; ++a) {
+            for (int b = 0; b < k; ++b) {
+                double sum = 0.0;
+                for (int v = 0; v < n; ++v) sum += (double)c[(size_t)v * k + a] * c[(size_t)v * k + b];
+                ctc[(size_t)a * k + b] = sum;
+            }
+        }
+    });
+    std::vector<std::vector<double>> axes(2, std::vector<double>(k));
+    for (int axis = 0; axis < 2; ++axis) {
+        std::vector<double>& x = axes[axis];
+        for (int p = 0; p < k; ++p) x[p] = 1.0 + 0.01 * ((p * 7 + axis * 3) % 11);
+        std::vector<double> y(k);
+        for (int iteration = 0; iteration < 200; ++iteration) {
+            for (int a = 0; a < k; ++a) {
+                double sum = 0.0;
+                for (int b = 0; b < k; ++b) sum += ctc[(size_t)a * k + b] * x[b];
+                y[a] = sum;
+            }
+            if (axis == 1) {
+                double dot = 0.0;
+                for (int p = 0; p < k; ++p) dot += y[p] * axes[0][p];
+                for (int p = 0; p < k; ++p) y[p] -= dot * axes[0][p];
+            }
+            double norm = 0.0;
+            for (double value : y) norm += value * value;
+            norm = sqrt(norm);
+            if (norm == 0.0) break;
+            double change = 0.0;
+            for (int p = 0; p < k; ++p) {
+                y[p] /= norm;
+                change += fabs(y[p] - x[p]);
+            }
+            x.swap(y);
+            if (change < 1e-9 * k) break;
+        }
+    }
+
+    // Project, give each axis length sqrt(sigma) as classical MDS would, then make edges one unit long
+    std::vector<float> projected[2] = {std::vector<float>(n), std::vector<float>(n)};
+    for (int axis = 0; axis < 2; ++axis) {
+        ParallelFor(0, n, 1024, [&](int begin, int end, int) {
+            for (int v = begin; v < end; ++v) {
+                double sum = 0.0;
+                for (int p = 0; p < k; ++p) sum += c[(size_t)v * k + p] * axes[axis][p];
+                projected[axis][v] = float(sum);
+            }
+        });
+        double norm = 0.0;
+        for (float value : projected[axis]) norm += (double)value * value;
+        norm = sqrt(norm);
+        if (norm > 0.0) {
+            float scale = float(sqrt(norm) / norm);
+            for (float& value : projected[axis]) value *= scale;
+        }
+    }
+    double length = 0.0;
+    long long links = 0;
+    for (int v = 0; v < n; ++v) {
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (*it < v) continue;
+            length += hypot(projected[0][v] - projected[0][*it], projected[1][v] - projected[1][*it]);
+            links++;
+        }
+    }
+    float scale = length > 0.0 ? float(links / length) : 1.0f;
+    for (int v = 0; v < n; ++v) coords[v] = ImVec2(projected[0][v] * scale, projected[1][v] * scale);
+    return coords;
+}
+
+// Initial layout from graph distances: pivot MDS of every connected component, the pieces packed into rows
+// largest first, scaled to `edge_length` and centered on `center`. A small jitter keeps nodes with identical
+// distances (leaves of one hub) from starting on top of each other, where no force could separate them.
+std::vector<ImVec2> PivotMDS(const CSRGraph& g, Pcg32& rng, ImVec2 center, int pivot_count = 50,
+                             float edge_length = 100.0f) {
+    int n = g.numNodes();
+    std::vector<ImVec2> positions(n, center);
+    if (n == 0) return positions;
+    BFSEngine bfs;
+    ComponentLabels components = ConnectedComponents(g, bfs);
+    int count = components.sizes.size();
+    std::vector<int> local(n);
+    std::vector<std::vector<int>> members(count);
+    for (int v = 0; v < n; ++v) {
+        local[v] = members[components.label[v]].size();
+        members[components.label[v]].push_back(v);
+    }
+
+    struct Piece {
+        std::vector<ImVec2> coords;
+        float min_x = 0, min_y = 0, width = 0, height = 0;
+    };
+    std::vector<Piece> pieces(count);
+    double area = 0.0;
+    for (int comp = 0; comp < count; ++comp) {
+        std::vector<std::pair<int, int>> links;
+        for (int v : members[comp]) {
+            for (const int* it = g.begin(v); it != g.end(v); ++it) {
+                if (*it > v) links.push_back({local[v], local[*it]});
+            }
+        }
+        Piece& piece = pieces[comp];
+        piece.coords = PivotMDSComponent(BuildCSRFromEdges(members[comp].size(), links, true), bfs, pivot_count);
+        float max_x = piece.coords[0].x, max_y = piece.coords[0].y;
+        piece.min_x = max_x;
+        piece.min_y = max_y;
+        for (const auto& p : piece.coords) {
+            piece.min_x = std::min(piece.min_x, p.x);
+            piece.min_y = std::min(piece.min_y, p.y);
+            max_x = std::max(max_x, p.x);
+            max_y = std::max(max_y, p.y);
+        }
+        piece.width = max_x - piece.min_x + 2.0f; // one edge length of margin on each side
+        piece.height = max_y - piece.min_y + 2.0f;
+        area += (double)piece.width * piece.height;
+    }
+
+    std::vector<int> order(count);
+    for (int comp = 0; comp < count; ++comp) order[comp] = comp;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return members[a].size() > members[b].size(); });
+    float row_limit = std::max(pieces[order[0]].width, float(sqrt(area)));
+    float x = 0.0f, y = 0.0f, row_height = 0.0f, total_width = 0.0f;
+    std::vector<ImVec2> offsets(count);
+    for (int comp : order) {
+        if (x > 0.0f && x + pieces[comp].width > row_limit) {
+            x = 0.0f;
+            y += row_height;
+            row_height = 0.0f;
+        }
+        offsets[comp] = ImVec2(x + 1.0f - pieces[comp].min_x, y + 1.0f - pieces[comp].min_y);
+        x += pieces[comp].width;
+        row_height = std::max(row_height, pieces[comp].height);
+        total_width = std::max(total_width, x);
+    }
+    float total_height = y + row_height;
+
+    for (int v = 0; v < n; ++v) {
+        int comp = components.label[v];
+        ImVec2 p = pieces[comp].coords[local[v]];
+        positions[v].x = center.x + (p.x + offsets[comp].x - 0.5f * total_width) * edge_length;
+        positions[v].x += edge_length * 0.05f * (rng.uniform() - 0.5f);
+        positions[v].y = center.y + (p.y + offsets[comp].y - 0.5f * total_height) * edge_length;
+        positions[v].y += edge_length * 0.05f * (rng.uniform() - 0.5f);
+    }
+    return positions;
+}
+
+// ForceAtlas2 mass of every node: degree + 1, counting parallel links
+std::vector<float> LayoutMasses(int n, const std::vector<std::pair<int, int>>& edges) {
+    std::vector<float> mass(n, 1.0f);
+    for (const auto& edge : edges) {
+        mass[edge.first] += 1.0f;
+        mass[edge.second] += 1.0f;
+    }
+    return mass;
+}
+
+// Weiszfeld iterations for the mass-weighted geometric median, the one point where constant-strength pulls of
+// an equilibrium cancel. LayoutEngine's gravity and SettleLocally both pull toward it.
+ImVec2 GravityCenter(const std::vector<ImVec2>& positions, const std::vector<float>& mass) {
+    int n = positions.size();
+    if (n == 0) return ImVec2(0.0f, 0.0f);
+    double center_x = 0.0, center_y = 0.0;
+    for (const auto& p : positions) {
+        center_x += p.x / n;
+        center_y += p.y / n;
+    }
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        double sum_x = 0.0, sum_y = 0.0, weight = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double w = mass[i] / std::max(hypot(positions[i].x - center_x, positions[i].y - center_y), 1.0);
+            sum_x += w * positions[i].x;
+            sum_y += w * positions[i].y;
+            weight += w;
+        }
+        double moved = hypot(sum_x / weight - center_x, sum_y / weight - center_y);
+        center_x = sum_x / weight;
+        center_y = sum_y / weight;
+        if (moved < 1e-3) break;
+    }
+    return ImVec2(float(center_x), float(center_y));
+}
+
+// Spring-electrical layout over SoA positions: inverse-square repulsion between all nodes (exact or
+// Barnes-Hut), linear springs of rest length 100 along edges, damped explicit integration. Pinned nodes
+// (the one being dragged) neither push nor get pushed, but still pull on their neighbors.
+class LayoutEngine {
+public:
+    enum RepulsionMode { REPULSION_EXACT = 0, REPULSION_BARNES_HUT = 1, REPULSION_GRID = 2 };
+
+    struct Settings {
+        int repulsion_mode = REPULSION_EXACT;
+        float barnes_hut_theta = 0.8f;
+        float grid_cutoff = 300.0f; // nodes further apart than this may ignore each other in grid mode
+        float time_step = 0.5f;
+        float repulsion_strength = 2000.0f;
+        float attraction_strength = 0.02f;
+        float damping = 0.9f;
+        // ForceAtlas2 adaptive speed instead of fixed time_step and damping: nodes whose force keeps flipping
+        // direction (swing) slow down, and the global speed follows the ratio of traction to swing
+        bool adaptive_speed = true;
+        float jitter_tolerance = 1.0f;
+        float max_displacement = 10.0f;
+        // The layout counts as settled once the mean displacement stays below this for kSettleSteps steps
+        float settle_distance = 0.05f;
+        float steps_per_second = 120.0f; // pace of the layout thread, 0 for as fast as possible
+        // Constant pull of (degree + 1) * gravity toward a point fixed by the last setPositions(), as in
+        // ForceAtlas2. Without it disconnected pieces drift apart forever and the layout never settles.
+        // The point is fixed so the pulls can balance; a moving centroid would drag the whole drawing along.
+        float gravity = 0.01f;
+    };
+    Settings settings;
+
+    static constexpr int kSettleSteps = 20;
+    static constexpr int kForceBlocks = 16;
+
+    void reset(const std::vector<std::pair<int, int>>& edge_list, const std::vector<ImVec2>& positions) {
+        edges = edge_list;
+        int n = positions.size();
+        pinned.assign(n, 0);
+        mass = LayoutMasses(n, edges);
+        setPositions(positions);
+    }
+
+    // Moves every node and drops all momentum
+    void setPositions(const std::vector<ImVec2>& positions) {
+        int n = positions.size();
+        xs.resize(n);
+        ys.resize(n);
+        for (int i = 0; i < n; ++i) {
+            xs[i] = positions[i].x;
+            ys[i] = positions[i].y;
+        }
+        vx.assign(n, 0.0f);
+        vy.assign(n, 0.0f);
+        // The geometric median, so a settled layout handed back in (a saved one) is still settled
+        ImVec2 center = GravityCenter(positions, mass);
+        gravity_x = center.x;
+        gravity_y = center.y;
+        previous_fx.assign(n, 0.0f);
+        previous_fy.assign(n, 0.0f);
+        global_speed = 1.0f;
+        wake();
+    }
+
+    // Takes nodes appended up to n, the links appended to the edge list and new places for some nodes, without
+    // touching the rest: the momentum of the others and the gravity centre stay. The adaptive speed starts over,
+    // as after setPositions(), since what it learned no longer matches the forces.
+    void extend(int n, const std::vector<std::pair<int, int>>& added_edges,
+                const std::vector<std::pair<int, ImVec2>>& moved) {
+        xs.resize(n);
+        ys.resize(n);
+        vx.resize(n, 0.0f);
+        vy.resize(n, 0.0f);
+        pinned.resize(n, 0);
+        mass.resize(n, 1.0f);
+        previous_fx.resize(n, 0.0f);
+        previous_fy.resize(n, 0.0f);
+        for (const auto& edge : added_edges) {
+            edges.push_back(edge);
+            mass[edge.first] += 1.0f;
+            mass[edge.second] += 1.0f;
+        }
+        for (const auto& node : moved) setPosition(node.first, node.second);
+        global_speed = 1.0f;
+        wake();
+    }
+
+    void setPosition(int node, ImVec2 position) {
+        xs[node] = position.x;
+        ys[node] = position.y;
+        vx[node] = vy[node] = 0.0f;
+        previous_fx[node] = previous_fy[node] = 0.0f;
+    }
+
+    // Quiet steps so far; the simulation can stop stepping once this reaches kSettleSteps
+    bool settled() const { return quiet_steps >= kSettleSteps; }
+    void wake() { quiet_steps = 0; }
+    // For positions already at rest, e.g. after an incremental placement: no stepping until the next wake()
+    void markSettled() { quiet_steps = kSettleSteps; }
+    float meanDisplacement() const { return mean_displacement; }
+    ImVec2 gravityCenter() const { return ImVec2(gravity_x, gravity_y); }
+    // Keeps gravity on a point from before setPositions(), e.g. across an incremental placement
+    void setGravityCenter(ImVec2 center) {
+        gravity_x = center.x;
+        gravity_y = center.y;
+    }
+
+    void setPinned(int node, bool pin) { pinned[node] = pin; }
+
+    int size() const { return xs.size(); }
+    const std::vector<std::pair<int, int>>& edgeList() const { return edges; }
+    ImVec2 position(int node) const { return ImVec2(xs[node], ys[node]); }
+
+    void copyPositions(std::vector<ImVec2>& out) const {
+        out.resize(xs.size());
+        for (int i = 0; i < (int)xs.size(); ++i) out[i] = ImVec2(xs[i], ys[i]);
+    }
+
+    void step() {
+        int n = xs.size();
+        // Repulsion: each node sums the push from every other movable node, so workers write only their own
+        // forces
+        movable.clear();
+        movable_x.clear();
+        movable_y.clear();
+        for (int i = 0; i < n; ++i) {
+            if (pinned[i]) continue;
+            movable.push_back(i);
+            movable_x.push_back(xs[i]);
+            movable_y.push_back(ys[i]);
+        }
+        int m = movable.size();
+        force_x.assign(n, 0.0f);
+        force_y.assign(n, 0.0f);
+        int mode = settings.repulsion_mode;
+        if (mode == REPULSION_BARNES_HUT) quadtree.build(movable_x, movable_y);
+        if (mode == REPULSION_GRID) grid.build(movable_x, movable_y, settings.grid_cutoff);
+        ParallelFor(0, m, mode == REPULSION_EXACT ? 32 : 64, [&](int begin, int end, int) {
+            for (int j = begin; j < end; ++j) {
+                // Grid queries go cell by cell so consecutive nodes read the same neighbor cells
+                int k = mode == REPULSION_GRID ? grid.pointOrder()[j] : j;
+                float fx = 0.0f, fy = 0.0f;
+                if (mode == REPULSION_BARNES_HUT) {
+                    quadtree.accumulateRepulsion(movable_x[k], movable_y[k], settings.repulsion_strength,
+                                                 settings.barnes_hut_theta, fx, fy);
+                } else if (mode == REPULSION_GRID) {
+                    grid.accumulateRepulsion(movable_x[k], movable_y[k], settings.repulsion_strength, fx, fy);
+                } else {
+                    AccumulateRepulsion(movable_x[k], movable_y[k], movable_x.data(), movable_y.data(), 0, m,
+                                        settings.repulsion_strength, fx, fy);
+                }
+                force_x[movable[k]] = fx;
+                force_y[movable[k]] = fy;
+            }
+        });
+
+        // Attraction: the edge list is cut into a fixed number of blocks, each adding into its own force
+        // buffer, and the buffers are summed per node in block order. The block count depends only on the
+        // graph, so the floating-point sums, and the layout, come out the same for any number of threads.
+        int edge_count = edges.size();
+        int blocks = std::max(1, std::min(kForceBlocks, edge_count / 4096));
+        if ((int)block_forces.size() != blocks) block_forces.assign(blocks, {});
+        for (auto& buffer : block_forces) buffer.assign(n, ImVec2(0.0f, 0.0f));
+        ParallelFor(0, blocks, 1, [&](int block_begin, int block_end, int) {
+            for (int block = block_begin; block < block_end; ++block) {
+                std::vector<ImVec2>& force_out = block_forces[block];
+                int first = (int)((long long)edge_count * block / blocks);
+                int last = (int)((long long)edge_count * (block + 1) / blocks);
+                for (int e = first; e < last; ++e) {
+                    int from = edges[e].first, to = edges[e].second;
+                    float dx = xs[to] - xs[from], dy = ys[to] - ys[from];
+                    float dist = sqrtf(dx * dx + dy * dy);
+                    if (dist < 1.0f) dist = 1.0f;
+                    float force = (dist - 100.0f) * settings.attraction_strength;
+                    float fx = dx / dist * force, fy = dy / dist * force;
+                    force_out[from].x += fx;
+                    force_out[from].y += fy;
+                    force_out[to].x -= fx;
+                    force_out[to].y -= fy;
+                }
+            }
+        });
+
+        // Net force, and for the adaptive speed the swing and traction of every node. Global sums are kept per
+        // fixed run of `grain` nodes and added in order, whichever worker handled each run.
+        const int grain = 256;
+        int chunks = (n + grain - 1) / grain;
+        std::vector<double> chunk_swing(chunks, 0.0), chunk_traction(chunks, 0.0);
+        ParallelFor(0, n, grain, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                if (pinned[i]) continue;
+                for (const auto& buffer : block_forces) {
+                    force_x[i] += buffer[i].x;
+                    force_y[i] += buffer[i].y;
+                }
+                float to_x = gravity_x - xs[i], to_y = gravity_y - ys[i];
+                float to_center = hypotf(to_x, to_y);
+                if (to_center > 1.0f) {
+                    force_x[i] += settings.gravity * mass[i] * to_x / to_center;
+                    force_y[i] += settings.gravity * mass[i] * to_y / to_center;
+                }
+                if (!settings.adaptive_speed) continue;
+                float swing = hypotf(force_x[i] - previous_fx[i], force_y[i] - previous_fy[i]);
+                float traction = 0.5f * hypotf(force_x[i] + previous_fx[i], force_y[i] + previous_fy[i]);
+                chunk_swing[i / grain] += mass[i] * swing;
+                chunk_traction[i / grain] += mass[i] * traction;
+            }
+        });
+        if (settings.adaptive_speed) {
+            double swing = 0.0, traction = 0.0;
+            for (int c = 0; c < chunks; ++c) {
+                swing += chunk_swing[c];
+                traction += chunk_traction[c];
+            }
+            // Speed may rise by at most half per step, but drops at once when the layout starts to oscillate
+            float target = swing > 0.0 ? float(settings.jitter_tolerance * traction / swing) : global_speed;
+            global_speed += std::min(target - global_speed, 0.5f * global_speed);
+        }
+
+        std::vector<double> chunk_displacement(chunks, 0.0);
+        ParallelFor(0, n, grain, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                if (pinned[i]) continue;
+                float dx, dy;
+                if (settings.adaptive_speed) {
+                    float swing = hypotf(force_x[i] - previous_fx[i], force_y[i] - previous_fy[i]);
+                    float speed = global_speed / (1.0f + global_speed * sqrtf(swing));
+                    float force = hypotf(force_x[i], force_y[i]);
+                    if (speed * force > settings.max_displacement) speed = settings.max_displacement / force;
+                    dx = force_x[i] * speed;
+                    dy = force_y[i] * speed;
+                    previous_fx[i] = force_x[i];
+                    previous_fy[i] = force_y[i];
+                } else {
+                    vx[i] += force_x[i];
+                    vy[i] += force_y[i];
+                    dx = vx[i] * settings.time_step;
+                    dy = vy[i] * settings.time_step;
+                    vx[i] *= settings.damping;
+                    vy[i] *= settings.damping;
+                }
+                xs[i] += dx;
+                ys[i] += dy;
+                chunk_displacement[i / grain] += hypotf(dx, dy);
+            }
+        });
+        double displacement = 0.0;
+        for (double d : chunk_displacement) displacement += d;
+        mean_displacement = m > 0 ? float(displacement / m) : 0.0f;
+        if (mean_displacement < settings.settle_distance) quiet_steps++;
+        else quiet_steps = 0;
+    }
+
+private:
+    std::vector<float> xs, ys, vx, vy;
+    std::vector<char> pinned;
+    std::vector<float> mass; // degree + 1, as in ForceAtlas2
+    std::vector<float> force_x, force_y, previous_fx, previous_fy;
+    float global_speed = 1.0f;
+    float gravity_x = 0.0f, gravity_y = 0.0f;
+    float mean_displacement = 0.0f;
+    int quiet_steps = 0;
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> movable;
+    std::vector<float> movable_x, movable_y;
+    QuadTree quadtree;
+    UniformGrid grid;
+    std::vector<std::vector<ImVec2>> block_forces;
+};
+
+// Scales positions about their centroid to the size that minimizes the energy of LayoutEngine's forces,
+// E(s) = k/2 sum (s l_e - 100)^2 + R/s sum 1/d_ij + s g sum m_i r_i, so a drawing with the right shape (pivot
+// MDS) also starts at the right size instead of spending most of the simulation growing or shrinking.
+// dE/ds = 0 is k S2 s^3 + (G - 100 k S1) s^2 - P = 0 with one positive root, found by bisection. Repulsion
+// is summed over all pairs of small graphs and over a fixed random sample of a million pairs otherwise.
+// Returns the factor applied.
+float FitLayoutScale(const std::vector<std::pair<int, int>>& edges, const LayoutEngine::Settings& settings,
+                     std::vector<ImVec2>& positions) {
+    const long long kMaxPairs = 1 << 20;
+    int n = positions.size();
+    if (n < 2) return 1.0f;
+    double center_x = 0.0, center_y = 0.0;
+    for (const auto& p : positions) {
+        center_x += p.x;
+        center_y += p.y;
+    }
+    center_x /= n;
+    center_y /= n;
+
+    double s1 = 0.0, s2 = 0.0, g = 0.0;
+    std::vector<float> mass(n, 1.0f);
+    for (const auto& edge : edges) {
+        double l = hypot(positions[edge.first].x - positions[edge.second].x,
+                         positions[edge.first].y - positions[edge.second].y);
+        s1 += l;
+        s2 += l * l;
+        mass[edge.first] += 1.0f;
+        mass[edge.second] += 1.0f;
+    }
+    for (int i = 0; i < n; ++i) g += mass[i] * hypot(positions[i].x - center_x, positions[i].y - center_y);
+    g *= settings.gravity;
+
+    long long all_pairs = (long long)n * (n - 1) / 2;
+    double inverse_sum = 0.0;
+    if (all_pairs <= kMaxPairs) {
+        std::vector<double> row_sums(n, 0.0);
+        ParallelFor(0, n, 64, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                for (int j = i + 1; j < n; ++j) {
+                    double d = hypot(positions[i].x - positions[j].x, positions[i].y - positions[j].y);
+                    row_sums[i] += 1.0 / std::max(d, 1.0);
+                }
+            }
+        });
+        for (double sum : row_sums) inverse_sum += sum;
+    } else {
+        Pcg32 rng(0x5ca1e);
+        for (long long s = 0; s < kMaxPairs; ++s) {
+            int i = rng.below(n), j = rng.below(n);
+            if (i == j) continue;
+            double d = hypot(positions[i].x - positions[j].x, positions[i].y - positions[j].y);
+            inverse_sum += 1.0 / std::max(d, 1.0);
+        }
+        inverse_sum *= (double)all_pairs / kMaxPairs;
+    }
+
+    double k = settings.attraction_strength;
+    double p = settings.repulsion_strength * inverse_sum;
+    auto slope = [&](double s) { return k * s2 * s * s * s + (g - 100.0 * k * s1) * s * s - p; };
+    double low = 1e-3, high = 1.0;
+    while (slope(high) < 0.0 && high < 1e6) high *= 2.0;
+    for (int iteration = 0; iteration < 60; ++iteration) {
+        double mid = 0.5 * (low + high);
+        (slope(mid) < 0.0 ? low : high) = mid;
+    }
+    float scale = float(0.5 * (low + high));
+    for (auto& position : positions) {
+        position.x = float(center_x + (position.x - center_x) * scale);
+        position.y = float(center_y + (position.y - center_y) * scale);
+    }
+    return scale;
+}
+
+// Multilevel force layout (Walshaw, "A multilevel algorithm for force-directed graph drawing"). The graph is
+// coarsened by random maximal matching, preferring light partners, until a few dozen clusters remain. The
+// coarsest graph is laid out starting from the mean incoming position of each cluster, and every finer level
+// starts at its parent cluster's position, so it needs only a short refinement. When matching stalls (stars,
+// hubs) unmatched nodes join a neighbor's cluster.
+// Keeps the centroid of the incoming positions; returns the number of steps run over all levels.
+int MultilevelLayout(int n, const std::vector<std::pair<int, int>>& edges, LayoutEngine::Settings settings,
+                     std::vector<ImVec2>& positions, int steps_per_level = 150, uint64_t seed = 1) {
+    const int kCoarsestNodes = 32;
+    const int kBarnesHutNodes = 2000;
+    struct Level {
+        int n = 0;
+        std::vector<std::pair<int, int>> edges;
+        std::vector<int> weight; // original nodes per cluster
+        std::vector<int> parent; // cluster on the next coarser level
+    };
+    std::vector<Level> levels(1);
+    levels[0].n = n;
+    levels[0].edges = edges;
+    levels[0].weight.assign(n, 1);
+    Pcg32 rng(seed);
+
+    while (levels.back().n > kCoarsestNodes) {
+        Level& fine = levels.back();
+        CSRGraph g = BuildCSRFromEdges(fine.n, fine.edges, true);
+        std::vector<int> order(fine.n);
+        for (int v = 0; v < fine.n; ++v) order[v] = v;
+        for (int v = fine.n - 1; v > 0; --v) std::swap(order[v], order[rng.below(v + 1)]);
+
+        std::vector<int> parent(fine.n, -1);
+        int clusters = 0;
+        for (int v : order) {
+            if (parent[v] >= 0) continue;
+            int partner = -1;
+            for (const int* it = g.begin(v); it != g.end(v); ++it) {
+                if (parent[*it] < 0 && (partner < 0 || fine.weight[*it] < fine.weight[partner])) partner = *it;
+            }
+            if (partner < 0) continue;
+            parent[v] = parent[partner] = clusters++;
+        }
+        bool stalled = clusters * 4 < fine.n; // matching removed less than a quarter of the nodes
+        for (int v : order) {
+            if (parent[v] >= 0) continue;
+            if (stalled) {
+                for (const int* it = g.begin(v); it != g.end(v) && parent[v] < 0; ++it) parent[v] = parent[*it];
+            }
+            if (parent[v] < 0) parent[v] = clusters++;
+        }
+        if (clusters > fine.n * 19 / 20) break; // nothing left to merge, e.g. no edges
+
+        Level coarse;
+        coarse.n = clusters;
+        coarse.weight.assign(clusters, 0);
+        for (int v = 0; v < fine.n; ++v) coarse.weight[parent[v]] += fine.weight[v];
+        for (const auto& edge : fine.edges) {
+            int a = parent[edge.first], b = parent[edge.second];
+            if (a != b) coarse.edges.push_back({std::min(a, b), std::max(a, b)});
+        }
+        std::sort(coarse.edges.begin(), coarse.edges.end());
+        coarse.edges.erase(std::unique(coarse.edges.begin(), coarse.edges.end()), coarse.edges.end());
+        fine.parent = std::move(parent);
+        levels.push_back(std::move(coarse));
+    }
+
+    float center_x = 0.0f, center_y = 0.0f;
+    for (const auto& p : positions) {
+        center_x += p.x;
+        center_y += p.y;
+    }
+    if (n > 0) {
+        center_x /= n;
+        center_y /= n;
+    }
+
+    auto unit = [&rng] { return rng.uniform() - 0.5f; };
+    std::vector<ImVec2> level_positions = positions;
+    level_positions.resize(n, ImVec2(center_x, center_y));
+    for (int l = 0; l + 1 < (int)levels.size(); ++l) {
+        std::vector<ImVec2> coarser(levels[l + 1].n, ImVec2(0.0f, 0.0f));
+        for (int v = 0; v < levels[l].n; ++v) {
+            int parent = levels[l].parent[v];
+            float share = (float)levels[l].weight[v] / levels[l + 1].weight[parent];
+            coarser[parent].x += level_positions[v].x * share;
+            coarser[parent].y += level_positions[v].y * share;
+        }
+        level_positions.swap(coarser);
+    }
+
+    int total_steps = 0;
+    for (int l = (int)levels.size() - 1; l >= 0; --l) {
+        const Level& level = levels[l];
+        if (l < (int)levels.size() - 1) {
+            std::vector<ImVec2> finer(level.n);
+            for (int v = 0; v < level.n; ++v) {
+                finer[v] = level_positions[level.parent[v]];
+                finer[v].x += 20.0f * unit();
+                finer[v].y += 20.0f * unit();
+            }
+            level_positions.swap(finer);
+        }
+        LayoutEngine engine;
+        engine.settings = settings;
+        if (level.n > kBarnesHutNodes) engine.settings.repulsion_mode = LayoutEngine::REPULSION_BARNES_HUT;
+        engine.reset(level.edges, level_positions);
+        int budget = l == (int)levels.size() - 1 ? 4 * steps_per_level : steps_per_level;
+        for (int s = 0; s < budget && !engine.settled(); ++s, ++total_steps) engine.step();
+        engine.copyPositions(level_positions);
+    }
+
+    float mean_x = 0.0f, mean_y = 0.0f;
+    for (const auto& p : level_positions) {
+        mean_x += p.x;
+        mean_y += p.y;
+    }
+    if (n > 0) {
+        mean_x /= n;
+        mean_y /= n;
+    }
+    positions.resize(n);
+    for (int v = 0; v < n; ++v) {
+        positions[v] = ImVec2(level_positions[v].x - mean_x + center_x, level_positions[v].y - mean_y + center_y);
+    }
+    return total_steps;
+}
+
+// Sparse stress majorization (Ortmann, Klimenta and Brandes, "A sparse stress model"). Stress, the sum of
+// w_ij (|x_i - x_j| - d_ij)^2 with d_ij the hop distance times the edge length and w_ij = 1/d_ij^2, is kept
+// exactly for pairs within `hop_cutoff` hops of each other along paths whose inner nodes have at most
+// kMaxCenterDegree links: expanding through a hub would add deg^2 terms, so pairs only joined through one
+// are left to the pivots like the far ones. Every other pair is stood in for by a term from each node to
+// each of k max-min pivots, weighted by how many nodes of that pivot's region lie within half the distance
+// of the pivot. Each iteration minimizes the majorant of this stress at the current positions, with pivots
+// held where they are for their terms to other nodes, as in the paper's update. That is one system per axis,
+// a Laplacian plus a positive diagonal, solved by Jacobi-preconditioned conjugate gradients warm-started
+// from the current positions. Products and dot products are split over the worker pool in fixed chunks, so
+// results do not depend on the number of threads.
+class StressMajorization {
+public:
+    StressMajorization(const CSRGraph& g, float edge_length, int hop_cutoff = 2, int pivot_count = 200) {
+        n = g.numNodes();
+        std::vector<std::vector<Term>> rows(n), anchor_rows(n);
+        std::vector<char> truncated(n, 0); // the BFS from this node skipped a hub, so its row misses pairs
+
+        // Exact terms: a BFS from every node, cut off after hop_cutoff levels and not continued through hubs
+        std::vector<std::vector<int>> worker_hops(WorkerCount(), std::vector<int>(n, -1));
+        std::vector<std::vector<int>> worker_queue(WorkerCount());
+        ParallelFor(0, n, 64, [&](int begin, int end, int worker) {
+            std::vector<int>& hops = worker_hops[worker];
+            std::vector<int>& queue = worker_queue[worker];
+            for (int v = begin; v < end; ++v) {
+                queue.assign(1, v);
+                hops[v] = 0;
+                for (size_t head = 0; head < queue.size(); ++head) {
+                    int u = queue[head];
+                    if (hops[u] == hop_cutoff) continue;
+                    if (u != v && g.degree(u) > kMaxCenterDegree) {
+                        truncated[v] = 1;
+                        continue;
+                    }
+                    for (const int* it = g.begin(u); it != g.end(u); ++it) {
+                        if (hops[*it] >= 0) continue;
+                        hops[*it] = hops[u] + 1;
+                        queue.push_back(*it);
+                    }
+                }
+                for (size_t i = 1; i < queue.size(); ++i) {
+                    float d = hops[queue[i]] * edge_length;
+                    rows[v].push_back({queue[i], 1.0f / (d * d), d});
+                }
+                for (int u : queue) hops[u] = -1;
+            }
+        });
+
+        // Pivot terms for the pairs further apart, anchoring each node to the pivots' current positions
+        int k = std::min({pivot_count, n, std::max(16, kMaxPivotTerms / std::max(n, 1))});
+        std::vector<int> pivots, pivot_hops((size_t)k * n), nearest(n, -1);
+        std::vector<int> nearest_hops(n, std::numeric_limits<int>::max());
+        BFSEngine bfs;
+        int pivot = 0;
+        for (int v = 1; v < n; ++v) {
+            if (g.degree(v) > g.degree(pivot)) pivot = v;
+        }
+        for (int p = 0; p < k; ++p) {
+            pivots.push_back(pivot);
+            bfs.run(g, pivot);
+            int next = pivot;
+            for (int v = 0; v < n; ++v) {
+                int hops = bfs.depth(v);
+                pivot_hops[(size_t)p * n + v] = hops;
+                if (hops >= 0 && hops < nearest_hops[v]) {
+                    nearest_hops[v] = hops;
+                    nearest[v] = p;
+                }
+                if (nearest_hops[v] > nearest_hops[next] && nearest_hops[v] != std::numeric_limits<int>::max()) next = v;
+            }
+            pivot = next;
+        }
+        std::vector<std::vector<int>> region_hops(k); // hops from each pivot to the nodes it is nearest to, sorted
+        for (int v = 0; v < n; ++v) {
+            if (nearest[v] >= 0) region_hops[nearest[v]].push_back(nearest_hops[v]);
+        }
+        for (auto& hops : region_hops) std::sort(hops.begin(), hops.end());
+        std::vector<int> exact_mark(n, -1);
+        for (int v = 0; v < n; ++v) {
+            if (truncated[v]) {
+                for (const Term& term : rows[v]) exact_mark[term.node] = v;
+            }
+            for (int p = 0; p < k; ++p) {
+                int s = pivots[p];
+                int hops = pivot_hops[(size_t)p * n + v];
+                if (hops <= 0) continue; // unreachable, or the pivot itself
+                if (hops <= hop_cutoff && (!truncated[v] || exact_mark[s] == v)) continue; // already an exact term
+                int represented = std::upper_bound(region_hops[p].begin(), region_hops[p].end(), hops / 2) -
+                                  region_hops[p].begin();
+                float d = hops * edge_length;
+                anchor_rows[v].push_back({s, std::max(represented, 1) / (d * d), d});
+            }
+        }
+
+        offsets.assign(n + 1, 0);
+        anchor_offsets.assign(n + 1, 0);
+        for (int v = 0; v < n; ++v) {
+            offsets[v + 1] = offsets[v] + rows[v].size();
+            anchor_offsets[v + 1] = anchor_offsets[v] + anchor_rows[v].size();
+        }
+        terms.resize(offsets[n]);
+        anchors.resize(anchor_offsets[n]);
+        diagonal.assign(n, 0.0f);
+        for (int v = 0; v < n; ++v) {
+            std::copy(rows[v].begin(), rows[v].end(), terms.begin() + offsets[v]);
+            std::copy(anchor_rows[v].begin(), anchor_rows[v].end(), anchors.begin() + anchor_offsets[v]);
+            for (const Term& term : rows[v]) diagonal[v] += term.weight;
+            for (const Term& term : anchor_rows[v]) diagonal[v] += term.weight;
+        }
+    }
+
+    int termCount() const { return terms.size() / 2 + anchors.size(); }
+
+    double stress(const std::vector<ImVec2>& positions) const {
+        std::vector<double> chunk_sums((n + kGrain - 1) / kGrain, 0.0);
+        ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+            for (int v = begin; v < end; ++v) {
+                for (int slot = offsets[v]; slot < offsets[v + 1]; ++slot) {
+                    const Term& term = terms[slot];
+                    double gap = hypot(positions[v].x - positions[term.node].x, positions[v].y - positions[term.node].y) -
+                                 term.distance;
+                    chunk_sums[v / kGrain] += 0.5 * term.weight * gap * gap; // every pair is stored twice
+                }
+                for (int slot = anchor_offsets[v]; slot < anchor_offsets[v + 1]; ++slot) {
+                    const Term& term = anchors[slot];
+                    double gap = hypot(positions[v].x - positions[term.node].x, positions[v].y - positions[term.node].y) -
+                                 term.distance;
+                    chunk_sums[v / kGrain] += term.weight * gap * gap;
+                }
+            }
+        });
+        double sum = 0.0;
+        for (double chunk : chunk_sums) sum += chunk;
+        return sum;
+    }
+
+    // One majorization step; returns the conjugate gradient iterations used over both axes
+    int iterate(std::vector<ImVec2>& positions, int max_cg_iterations = 50, double tolerance = 1e-4) {
+        std::vector<double> x[2], b[2];
+        for (int axis = 0; axis < 2; ++axis) {
+            x[axis].resize(n);
+            b[axis].assign(n, 0.0);
+        }
+        for (int v = 0; v < n; ++v) {
+            x[0][v] = positions[v].x;
+            x[1][v] = positions[v].y;
+        }
+        ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+            for (int v = begin; v < end; ++v) {
+                for (int slot = offsets[v]; slot < offsets[v + 1]; ++slot) {
+                    const Term& term = terms[slot];
+                    double dx = x[0][v] - x[0][term.node], dy = x[1][v] - x[1][term.node];
+                    double length = hypot(dx, dy);
+                    if (length < 1e-6) continue;
+                    double scale = term.weight * term.distance / length;
+                    b[0][v] += scale * dx;
+                    b[1][v] += scale * dy;
+                }
+                for (int slot = anchor_offsets[v]; slot < anchor_offsets[v + 1]; ++slot) {
+                    const Term& term = anchors[slot];
+                    double dx = x[0][v] - x[0][term.node], dy = x[1][v] - x[1][term.node];
+                    double length = std::max(hypot(dx, dy), 1e-6);
+                    double scale = term.weight * term.distance / length;
+                    b[0][v] += term.weight * x[0][term.node] + scale * dx;
+                    b[1][v] += term.weight * x[1][term.node] + scale * dy;
+                }
+            }
+        });
+        int total = 0;
+        for (int axis = 0; axis < 2; ++axis) total += solve(b[axis], x[axis], max_cg_iterations, tolerance);
+        for (int v = 0; v < n; ++v) positions[v] = ImVec2(float(x[0][v]), float(x[1][v]));
+        return total;
+    }
+
+private:
+    struct Term {
+        int node;
+        float weight;
+        float distance;
+    };
+    static constexpr int kGrain = 256;
+    static constexpr int kMaxPivotTerms = 1 << 24; // fewer pivots on huge graphs, to bound memory
+    static constexpr int kMaxCenterDegree = 32;    // with hop_cutoff 2, at most 2 x kMaxCenterDegree stored terms per link
+
+    int n = 0;
+    std::vector<int> offsets, anchor_offsets;
+    std::vector<Term> terms, anchors;
+    std::vector<float> diagonal;
+
+    // out = L in, with L the weighted Laplacian of the exact terms plus the anchor weights on its diagonal
+    void multiply(const std::vector<double>& in, std::vector<double>& out) const {
+        ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+            for (int v = begin; v < end; ++v) {
+                double sum = diagonal[v] * in[v];
+                for (int slot = offsets[v]; slot < offsets[v + 1]; ++slot) sum -= terms[slot].weight * in[terms[slot].node];
+                out[v] = sum;
+            }
+        });
+    }
+
+    double dot(const std::vector<double>& a, const std::vector<double>& b) const {
+        std::vector<double> chunk_sums((n + kGrain - 1) / kGrain, 0.0);
+        ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+            for (int v = begin; v < end; ++v) chunk_sums[v / kGrain] += a[v] * b[v];
+        });
+        double sum = 0.0;
+        for (double chunk : chunk_sums) sum += chunk;
+        return sum;
+    }
+
+    // Preconditioned conjugate gradients for L x = b. Without anchors (components too small to reach past
+    // hop_cutoff) L is singular by translation, but b then sums to zero over the component, so the system is
+    // still consistent and any solution will do.
+    int solve(const std::vector<double>& b, std::vector<double>& x, int max_iterations, double tolerance) const {
+        std::vector<double> r(n), z(n), p(n), q(n);
+        multiply(x, q);
+        for (int v = 0; v < n; ++v) {
+            r[v] = b[v] - q[v];
+            z[v] = diagonal[v] > 0.0f ? r[v] / diagonal[v] : 0.0;
+        }
+        p = z;
+        double rz = dot(r, z);
+        double limit = tolerance * tolerance * dot(b, b);
+        int iteration = 0;
+        while (iteration < max_iterations && dot(r, r) > limit) {
+            multiply(p, q);
+            double pq = dot(p, q);
+            if (pq <= 0.0) break;
+            double alpha = rz / pq;
+            ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+                for (int v = begin; v < end; ++v) {
+                    x[v] += alpha * p[v];
+                    r[v] -= alpha * q[v];
+                    z[v] = diagonal[v] > 0.0f ? r[v] / diagonal[v] : 0.0;
+                }
+            });
+            double rz_next = dot(r, z);
+            double beta = rz_next / rz;
+            rz = rz_next;
+            ParallelFor(0, n, kGrain, [&](int begin, int end, int) {
+                for (int v = begin; v < end; ++v) p[v] = z[v] + beta * p[v];
+            });
+            iteration++;
+        }
+        return iteration;
+    }
+};
+
+// Incremental placement: settles the `moving` nodes while every other node stays where it is. Forces are
+// LayoutEngine's springs and repulsion, but steps are capped by a temperature that cools geometrically
+// (Fruchterman-Reingold), so the added energy drains in a fixed number of steps. Only fixed nodes in the
+// grid cells (of the cutoff's size) around moving ones push. They come from nodes_near(lo, hi, out), which
+// lists at least the nodes within a box (ViewportIndex::queryNodes), and are looked up again whenever a moving
+// node enters another cell, so a step costs O(moving x (moving + nearby)) whatever the size of the graph.
+// Gravity toward `center`, which should be the engine's (LayoutEngine::gravityCenter), keeps new pieces that
+// are not linked to the rest from being pushed away. position(v) is the ImVec2& of v. Returns the steps taken.
+template <typename PositionFn, typename NearFn>
+int SettleLocally(const CSRGraph& g, const std::vector<int>& moving, PositionFn position, NearFn nodes_near,
+                  const LayoutEngine::Settings& settings, ImVec2 center, int max_steps = 300) {
+    int count = moving.size();
+    if (count == 0) return 0;
+    std::vector<int> sorted_moving(moving);
+    std::sort(sorted_moving.begin(), sorted_moving.end());
+    auto is_moving = [&](int v) { return std::binary_search(sorted_moving.begin(), sorted_moving.end(), v); };
+    float reach = settings.grid_cutoff;
+    auto cell = [reach](float x, float y) {
+        return std::make_pair((long long)floorf(x / reach), (long long)floorf(y / reach));
+    };
+
+    // Repulsion sources: the moving nodes first, then the fixed ones in the 3x3 cells around each of them
+    std::vector<float> xs(count), ys(count);
+    std::vector<std::pair<long long, long long>> moving_cell(count);
+    for (int k = 0; k < count; ++k) {
+        xs[k] = position(moving[k]).x;
+        ys[k] = position(moving[k]).y;
+    }
+    std::vector<int> candidates;
+    auto collect_fixed = [&]() {
+        xs.resize(count);
+        ys.resize(count);
+        std::set<std::pair<long long, long long>> near_cells;
+        for (int k = 0; k < count; ++k) {
+            moving_cell[k] = cell(xs[k], ys[k]);
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) near_cells.insert({moving_cell[k].first + dx, moving_cell[k].second + dy});
+            }
+        }
+        for (const auto& c : near_cells) {
+            nodes_near(ImVec2(c.first * reach, c.second * reach), ImVec2((c.first + 1) * reach, (c.second + 1) * reach),
+                       candidates);
+            for (int v : candidates) {
+                ImVec2 p = position(v);
+                if (cell(p.x, p.y) != c || is_moving(v)) continue;
+                xs.push_back(p.x);
+                ys.push_back(p.y);
+            }
+        }
+    };
+    collect_fixed();
+
+    std::vector<ImVec2> force(count);
+    float temperature = 50.0f;
+    int steps = 0;
+    while (steps < max_steps && temperature > settings.settle_distance) {
+        ParallelFor(0, count, 64, [&](int begin, int end, int) {
+            for (int k = begin; k < end; ++k) {
+                int v = moving[k];
+                float fx = 0.0f, fy = 0.0f;
+                AccumulateRepulsion(xs[k], ys[k], xs.data(), ys.data(), 0, xs.size(), settings.repulsion_strength, fx, fy);
+                for (const int* it = g.begin(v); it != g.end(v); ++it) {
+                    ImVec2 other = position(*it);
+                    float dx = other.x - xs[k], dy = other.y - ys[k];
+                    float dist = std::max(sqrtf(dx * dx + dy * dy), 1.0f);
+                    float pull = (dist - 100.0f) * settings.attraction_strength;
+                    fx += dx / dist * pull;
+                    fy += dy / dist * pull;
+                }
+                float to_x = center.x - xs[k], to_y = center.y - ys[k];
+                float to_center = hypotf(to_x, to_y);
+                if (to_center > 1.0f) {
+                    fx += settings.gravity * (g.degree(v) + 1) * to_x / to_center;
+                    fy += settings.gravity * (g.degree(v) + 1) * to_y / to_center;
+                }
+                force[k] = ImVec2(fx, fy);
+            }
+        });
+        float largest = 0.0f;
+        bool changed_cell = false;
+        for (int k = 0; k < count; ++k) {
+            float length = hypotf(force[k].x, force[k].y);
+            float move = std::min(length, temperature);
+            if (length > 0.0f) {
+                xs[k] += force[k].x / length * move;
+                ys[k] += force[k].y / length * move;
+            }
+            position(moving[k]) = ImVec2(xs[k], ys[k]);
+            largest = std::max(largest, move);
+            changed_cell = changed_cell || cell(xs[k], ys[k]) != moving_cell[k];
+        }
+        steps++;
+        if (largest < settings.settle_distance) break;
+        if (changed_cell) collect_fixed();
+        temperature *= 0.97f;
+    }
+    return steps;
+}
+
+// Layer of every node from its type, for data with a pad -> component -> metric style hierarchy. Types
+// that are never the subject of a link (metrics, statuses) share the last layer; the others get a layer each,
+// fewest distinct nodes first, on the grounds that containers are fewer than their contents. Ties keep the
+// order of first appearance. Untyped nodes count as one more type.
+std::vector<int> TypeLayers(const std::vector<std::string>& types, const std::vector<std::pair<int, int>>& links) {
+    std::map<std::string, int> type_index;
+    std::vector<int> node_type(types.size());
+    for (size_t v = 0; v < types.size(); ++v) {
+        auto inserted = type_index.emplace(types[v], (int)type_index.size());
+        node_type[v] = inserted.first->second;
+    }
+    int count = type_index.size();
+    std::vector<int> members(count, 0), first_seen(count, -1);
+    std::vector<char> has_subject(count, 0);
+    for (size_t v = 0; v < types.size(); ++v) {
+        members[node_type[v]]++;
+        if (first_seen[node_type[v]] < 0) first_seen[node_type[v]] = v;
+    }
+    for (const auto& link : links) has_subject[node_type[link.first]] = 1;
+    std::vector<int> containers;
+    for (int t = 0; t < count; ++t) {
+        if (has_subject[t]) containers.push_back(t);
+    }
+    std::sort(containers.begin(), containers.end(), [&](int a, int b) {
+        return members[a] != members[b] ? members[a] < members[b] : first_seen[a] < first_seen[b];
+    });
+    std::vector<int> type_layer(count, containers.size());
+    for (size_t rank = 0; rank < containers.size(); ++rank) type_layer[containers[rank]] = rank;
+    std::vector<int> layer(types.size());
+    for (size_t v = 0; v < types.size(); ++v) layer[v] = type_layer[node_type[v]];
+    return layer;
+}
+
+// Sugiyama crossing reduction: orders the nodes of each layer by the barycenter of their neighbors' relative
+// places in the layers before (downward sweeps) or after (upward sweeps) it. Links that skip layers count
+// directly instead of through dummy nodes. O(sweeps (m + n log n)) and deterministic, ties broken by node id.
+std::vector<std::vector<int>> OrderLayers(const CSRGraph& g, const std::vector<int>& layer, int sweeps = 4) {
+    int n = g.numNodes();
+    int layers = n ? *std::max_element(layer.begin(), layer.end()) + 1 : 0;
+    std::vector<std::vector<int>> rows(layers);
+    for (int v = 0; v < n; ++v) rows[layer[v]].push_back(v);
+    std::vector<float> place(n), key(n);
+    auto number = [&](const std::vector<int>& row) {
+        for (size_t i = 0; i < row.size(); ++i) place[row[i]] = (i + 0.5f) / row.size();
+    };
+    for (const auto& row : rows) number(row);
+    for (int sweep = 0; sweep < sweeps; ++sweep) {
+        bool down = sweep % 2 == 0;
+        for (int k = 1; k < layers; ++k) {
+            int l = down ? k : layers - 1 - k;
+            std::vector<int>& row = rows[l];
+            for (int v : row) {
+                float sum = 0.0f;
+                int neighbors = 0;
+                for (const int* it = g.begin(v); it != g.end(v); ++it) {
+                    if (down ? layer[*it] < l : layer[*it] > l) {
+                        sum += place[*it];
+                        neighbors++;
+                    }
+                }
+                key[v] = neighbors ? sum / neighbors : place[v];
+            }
+            std::sort(row.begin(), row.end(), [&](int a, int b) { return key[a] != key[b] ? key[a] < key[b] : a < b; });
+            number(row);
+        }
+    }
+    return rows;
+}
+
+// Layers as columns, each centered vertically on y = 300
+std::vector<ImVec2> LayeredPositions(const std::vector<std::vector<int>>& rows, int n) {
+    std::vector<ImVec2> positions(n);
+    for (size_t l = 0; l < rows.size(); ++l) {
+        for (size_t i = 0; i < rows[l].size(); ++i) {
+            positions[rows[l][i]] = ImVec2(100.0f + l * 180.0f, 300.0f + (i - 0.5f * (rows[l].size() - 1)) * 80.0f);
+        }
+    }
+    return positions;
+}
+
+// Layers as rings around (400, 300), in the order OrderLayers found, each ring wide enough for its nodes
+std::vector<ImVec2> RadialPositions(const std::vector<std::vector<int>>& rows, int n) {
+    std::vector<ImVec2> positions(n);
+    float radius = 0.0f;
+    for (size_t l = 0; l < rows.size(); ++l) {
+        int count = rows[l].size();
+        if (count == 0) continue;
+        if (l == 0 && count == 1) {
+            positions[rows[l][0]] = ImVec2(400.0f, 300.0f);
+            continue;
+        }
+        radius = std::max(radius + 180.0f, count * 80.0f / 6.2831853f);
+        for (int i = 0; i < count; ++i) {
+            float angle = 6.2831853f * (i + 0.5f) / count;
+            positions[rows[l][i]] = ImVec2(400.0f + radius * cosf(angle), 300.0f + radius * sinf(angle));
+        }
+    }
+    return positions;
+}
+
+struct StressReport {
+    int iterations = 0;
+    int terms = 0;
+    double setup_ms = 0.0;
+    double ms_per_iteration = 0.0;
+    double initial_stress = 0.0, final_stress = 0.0; // of the sparse model
+};
+
+// Refines a finished layout by sparse stress majorization, keeping its mean edge length as the unit of graph
+// distance so the drawing keeps its size. Stops after `max_iterations` or once an iteration lowers the stress
+// by less than `min_improvement` of its value.
+StressReport RefineStress(const CSRGraph& g, std::vector<ImVec2>& positions, int max_iterations = 100,
+                          double min_improvement = 1e-3) {
+    using Clock = std::chrono::steady_clock;
+    StressReport report;
+    double length = 0.0;
+    long long links = 0;
+    for (int v = 0; v < g.numNodes(); ++v) {
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (*it <= v) continue;
+            length += hypot(positions[v].x - positions[*it].x, positions[v].y - positions[*it].y);
+            links++;
+        }
+    }
+    if (links == 0 || length == 0.0) return report;
+    auto start = Clock::now();
+    StressMajorization model(g, float(length / links));
+    report.terms = model.termCount();
+    report.initial_stress = report.final_stress = model.stress(positions);
+    report.setup_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    while (report.iterations < max_iterations) {
+        std::vector<ImVec2> next = positions;
+        model.iterate(next);
+        double stress = model.stress(next);
+        report.iterations++;
+        if (stress >= report.final_stress) break; // the pivot anchors lag a step, so this can stall upward
+        positions.swap(next);
+        bool done = report.final_stress - stress < min_improvement * report.final_stress;
+        report.final_stress = stress;
+        if (done) break;
+    }
+    report.ms_per_iteration =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count() / std::max(report.iterations, 1);
+    return report;
+}
+
+// Runs a LayoutEngine on its own thread so a slow step never holds up a frame. The UI thread changes the
+// simulation only through post(), whose commands are applied between steps, and reads positions through a
+// lock-free triple buffer: latest() hands out the newest finished step without waiting on the simulation.
+class LayoutThread {
+public:
+    struct Snapshot {
+        std::vector<ImVec2> positions;
+        unsigned long long commands_applied = 0; // every post() numbered up to this is reflected
+        double step_ms = 0.0;
+        bool settled = false;                    // the thread is asleep until the next command
+        ImVec2 gravity_center;                   // see LayoutEngine::gravityCenter()
+    };
+
+    ~LayoutThread() { stop(); }
+
+    void start(const std::vector<std::pair<int, int>>& edges, const std::vector<ImVec2>& positions,
+               const LayoutEngine::Settings& settings, bool run, bool settled = false) {
+        stop();
+        engine.settings = settings;
+        engine.reset(edges, positions);
+        if (settled) engine.markSettled();
+        running = run;
+        commands.clear();
+        posted = applied = 0;
+        for (auto& buffer : buffers) {
+            buffer.positions = positions;
+            buffer.commands_applied = 0;
+        }
+        back = 0;
+        middle.store(1);
+        front = 2;
+        quit = false;
+        worker = std::thread([this] { loop(); });
+    }
+
+    // Like start(), but a running thread takes the new graph between two steps instead of being joined, so the
+    // caller does not wait for the current step. Returns the sequence number of the swap (see post()).
+    unsigned long long restart(const std::vector<std::pair<int, int>>& edges, const std::vector<ImVec2>& positions,
+                               const LayoutEngine::Settings& settings, bool run, bool settled = false) {
+        if (!worker.joinable()) {
+            start(edges, positions, settings, run, settled);
+            return 0;
+        }
+        setRunning(run);
+        return post([edges, positions, settings, settled](LayoutEngine& engine) {
+            engine.settings = settings;
+            engine.reset(edges, positions);
+            if (settled) engine.markSettled();
+        });
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    // Queues a change to the simulation and returns its sequence number, see Snapshot::commands_applied
+    unsigned long long post(std::function<void(LayoutEngine&)> command) {
+        unsigned long long sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            commands.push_back(std::move(command));
+            sequence = ++posted;
+        }
+        wake.notify_one();
+        return sequence;
+    }
+
+    void setRunning(bool run) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = run;
+        }
+        wake.notify_one();
+    }
+
+    // The newest step published since the last call, or nullptr if there is none. The snapshot stays valid
+    // until the next call.
+    const Snapshot* latest() {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return nullptr;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        return &buffers[front];
+    }
+
+    // True when the simulation sleeps with nothing queued and its last step already handed out by latest(),
+    // so positions cannot change before the next command
+    bool idle() {
+        if (!worker.joinable()) return true;
+        std::lock_guard<std::mutex> lock(mutex);
+        return sleeping && commands.empty() && !(middle.load(std::memory_order_acquire) & kFresh);
+    }
+
+private:
+    static constexpr int kFresh = 4;
+    static constexpr int kIndexMask = 3;
+    static constexpr int kMaxCatchUp = 4;
+
+    LayoutEngine engine;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::function<void(LayoutEngine&)>> commands;
+    unsigned long long posted = 0, applied = 0;
+    bool running = true;
+    bool quit = false;
+    bool sleeping = false;
+    Snapshot buffers[3];
+    int back = 0, front = 2;           // owned by the simulation and the UI thread respectively
+    std::atomic<int> middle{1};        // index of the spare buffer, kFresh if it holds an unread step
+
+    // Steps are paced by a fixed-timestep accumulator: settings.steps_per_second of wall time, whatever the
+    // frame rate, with at most kMaxCatchUp steps per round when the machine falls behind (the rest of the
+    // backlog is dropped). A rate of 0 steps back to back.
+    void loop() {
+        using Clock = std::chrono::steady_clock;
+        std::vector<std::function<void(LayoutEngine&)>> pending;
+        Clock::time_point next_step = Clock::now();
+        bool was_active = false;
+        for (;;) {
+            bool changed, run;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;) {
+                    if (quit) return;
+                    if (!commands.empty()) break;
+                    bool active = running && !engine.settled();
+                    if (!active) {
+                        // A paused or settled layout sleeps here until a drag, new positions or a settings change
+                        sleeping = true;
+                        wake.wait(lock);
+                        sleeping = false;
+                        continue;
+                    }
+                    if (!was_active || engine.settings.steps_per_second <= 0.0f || Clock::now() >= next_step) break;
+                    wake.wait_until(lock, next_step);
+                }
+                pending.swap(commands);
+                changed = !pending.empty();
+                applied = posted;
+                run = running;
+            }
+            for (auto& command : pending) command(engine);
+            pending.clear();
+            if (changed) engine.wake();
+
+            bool active = run && !engine.settled();
+            Clock::time_point now = Clock::now();
+            if (active && !was_active) next_step = now;
+            was_active = active;
+            int steps = 0;
+            if (active && engine.settings.steps_per_second <= 0.0f) {
+                steps = 1;
+            } else if (active && now >= next_step) {
+                auto interval = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / engine.settings.steps_per_second));
+                steps = std::min<long long>(kMaxCatchUp, 1 + (now - next_step) / interval);
+                next_step += steps * interval;
+                if (next_step < now) next_step = now;
+            }
+            if (steps == 0 && !changed) continue;
+
+            double step_ms = 0.0;
+            if (steps > 0) {
+                auto step_start = Clock::now();
+                int done = 0;
+                while (done < steps && !engine.settled()) {
+                    engine.step();
+                    done++;
+                }
+                step_ms = std::chrono::duration<double, std::milli>(Clock::now() - step_start).count() / std::max(done, 1);
+            }
+            Snapshot& out = buffers[back];
+            engine.copyPositions(out.positions);
+            out.commands_applied = applied;
+            out.step_ms = step_ms;
+            out.settled = engine.settled();
+            out.gravity_center = engine.gravityCenter();
+            back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+        }
+    }
+};
+
+// Recursive-matrix random graph (Chakrabarti et al.) with the Graph500 quadrant probabilities.
+// Deterministic for a given seed regardless of the thread count.
+CSRGraph GenerateRMAT(int scale, int edge_factor, unsigned seed = 1) {
+    int n = 1 << scale;
+    long long m = (long long)n * edge_factor;
+    std::vector<std::pair<int, int>> edge_list(m);
+    const int block = 1 << 16;
+    int blocks = (int)((m + block - 1) / block);
+    ParallelFor(0, blocks, 1, [&](int begin, int end, int) {
+        for (int b = begin; b < end; ++b) {
+            Pcg32 rng(seed, b);
+            long long last = std::min(m, (long long)(b + 1) * block);
+            for (long long e = (long long)b * block; e < last; ++e) {
+                int u = 0, v = 0;
+                for (int bit = 0; bit < scale; ++bit) {
+                    float r = rng.uniform();
+                    if (r < 0.57f) {
+                    } else if (r < 0.76f) {
+                        v |= 1 << bit;
+                    } else if (r < 0.95f) {
+                        u |= 1 << bit;
+                    } else {
+                        u |= 1 << bit;
+                        v |= 1 << bit;
+                    }
+                }
+                edge_list[e] = {u, v};
+            }
+        }
+    });
+    return BuildCSRFromEdges(n, edge_list, true);
+}
+
+// Times direction-optimizing BFS against plain top-down BFS from the same random roots
+int RunBFSBenchmark(int scale, int edge_factor) {
+    auto start = std::chrono::steady_clock::now();
+    CSRGraph g = GenerateRMAT(scale, edge_factor);
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "R-MAT scale " << scale << ", edge factor " << edge_factor << ": " << g.numNodes() << " nodes, "
+              << g.neighbors.size() / 2 << " undirected edges (built in " << build_ms << " ms, "
+              << WorkerCount() << " threads)" << std::endl;
+
+    Pcg32 rng(7);
+    std::vector<int> roots;
+    for (int attempt = 0; attempt < 1000 && roots.size() < 16; ++attempt) {
+        int v = rng.below(g.numNodes());
+        if (g.degree(v) > 0) roots.push_back(v);
+    }
+
+    BFSEngine bfs;
+    const BFSEngine::Direction modes[] = {BFSEngine::Direction::TopDownOnly, BFSEngine::Direction::Optimizing};
+    const char* names[] = {"top-down", "direction-optimizing"};
+    for (int mode = 0; mode < 2; ++mode) {
+        bfs.direction = modes[mode];
+        double total_ms = 0.0, total_edges = 0.0;
+        for (int root : roots) {
+            auto t0 = std::chrono::steady_clock::now();
+            bfs.run(g, root);
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            long long traversed = 0;
+            for (int v : bfs.order()) traversed += g.degree(v);
+            total_edges += traversed / 2.0;
+        }
+        std::cout << names[mode] << ": " << total_ms / roots.size() << " ms per search, "
+                  << total_edges / (total_ms * 1000.0) << " MTEPS" << std::endl;
+    }
+    return 0;
+}
+
+// Numbers the nodes of `triples` in order of first appearance, subject before object
+std::map<std::string, int> IndexTripleNodes(const std::vector<Triple>& triples, std::vector<std::string>& labels) {
+    std::map<std::string, int> node_map;
+    labels.clear();
+    for (const auto& triple : triples) {
+        for (const std::string* name : {&triple.node_name, &triple.name_of_component}) {
+            if (node_map.emplace(*name, (int)labels.size()).second) labels.push_back(*name);
+        }
+    }
+    return node_map;
+}
+
+// The layout's springs: one per triple between distinct nodes, in file order
+std::vector<std::pair<int, int>> TripleLinks(const std::vector<Triple>& triples, std::map<std::string, int>& node_map) {
+    std::vector<std::pair<int, int>> links;
+    for (const auto& triple : triples) {
+        int from = node_map[triple.node_name], to = node_map[triple.name_of_component];
+        if (from != to) links.push_back({from, to});
+    }
+    return links;
+}
+
+// Terms of GraphContentHash: one per label and one per link between two label fingerprints
+uint64_t MixBits(uint64_t x) { // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t LabelFingerprint(const std::string& label) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : label) hash = (hash ^ c) * 1099511628211ULL;
+    return hash;
+}
+
+uint64_t LabelHashTerm(uint64_t label) { return MixBits(label); }
+uint64_t LinkHashTerm(uint64_t from, uint64_t to) { return MixBits(from * 0x9e3779b97f4a7c15ULL ^ MixBits(to)); }
+
+// Fingerprint of a graph's node labels and links that ignores the order of the triples, so a reordered file
+// keeps its cached layout while any added or removed node or link changes the hash. As a sum of terms it
+// grows with an append by just the terms of the new nodes and links.
+uint64_t GraphContentHash(const std::vector<std::string>& labels, const std::vector<std::pair<int, int>>& links) {
+    std::vector<uint64_t> fingerprints(labels.size());
+    uint64_t hash = 0;
+    for (size_t i = 0; i < labels.size(); ++i) {
+        fingerprints[i] = LabelFingerprint(labels[i]);
+        hash += LabelHashTerm(fingerprints[i]);
+    }
+    for (const auto& link : links) hash += LinkHashTerm(fingerprints[link.first], fingerprints[link.second]);
+    return hash;
+}
+
+// Node positions saved next to a CSV as "<csv>.layout": a "# layout <hash>" line, then one "x,y,label" per node
+struct LayoutCache {
+    uint64_t graph_hash = 0;
+    std::map<std::string, ImVec2> positions;
+};
+
+bool ReadLayoutCache(const std::string& filename, LayoutCache& cache) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    std::string line;
+    if (!std::getline(file, line) || line.compare(0, 9, "# layout ") != 0) {
+        std::cerr << "Warning: Ignoring malformed layout cache " << filename << std::endl;
+        return false;
+    }
+    cache.graph_hash = std::strtoull(line.c_str() + 9, nullptr, 16);
+    cache.positions.clear();
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find(','), second = line.find(',', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+        ImVec2 p(std::strtof(line.c_str(), nullptr), std::strtof(line.c_str() + first + 1, nullptr));
+        if (std::isfinite(p.x) && std::isfinite(p.y)) cache.positions[line.substr(second + 1)] = p;
+    }
+    return true;
+}
+
+bool WriteLayoutCache(const std::string& filename, uint64_t graph_hash, const std::vector<std::string>& labels,
+                      const std::vector<ImVec2>& positions) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write file " << filename << std::endl;
+        return false;
+    }
+    file << "# layout " << std::hex << graph_hash << std::dec << "\n";
+    file << std::setprecision(std::numeric_limits<float>::max_digits10); // reloads bit for bit
+    for (size_t i = 0; i < labels.size(); ++i) file << positions[i].x << "," << positions[i].y << "," << labels[i] << "\n";
+    return true;
+}
+
+// The same positions as {"nodes": [{"id": label, "x": x, "y": y, "fx": x, "fy": y}, ...]} for the web frontend.
+// d3's forces overwrite x and y on their first tick; fx and fy are what pins a node there.
+bool WriteLayoutJSON(const std::string& filename, const std::vector<std::string>& labels,
+                     const std::vector<ImVec2>& positions) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write file " << filename << std::endl;
+        return false;
+    }
+    file << std::setprecision(std::numeric_limits<float>::max_digits10) << "{\"nodes\": [";
+    for (size_t i = 0; i < labels.size(); ++i) {
+        file << (i ? ",\n  " : "\n  ") << "{\"id\": \"";
+        for (unsigned char c : labels[i]) {
+            if (c == '"' || c == '\\') file << '\\' << c;
+            else if (c < 0x20) file << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+            else file << c;
+        }
+        file << "\", \"x\": " << positions[i].x << ", \"y\": " << positions[i].y << ", \"fx\": " << positions[i].x
+             << ", \"fy\": " << positions[i].y << "}";
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+// Gives every node without a position one next to its placed neighbors: nodes are visited in breadth-first
+// order from the placed ones and put at the mean of their already placed neighbors, plus a jitter of half an
+// edge length so siblings do not coincide. Nodes in components with nothing placed go on a circle just outside
+// the placed ones. Returns how many nodes were placed.
+int PlaceNearNeighbors(const CSRGraph& g, std::vector<ImVec2>& positions, std::vector<char>& placed, Pcg32& rng) {
+    int n = g.numNodes();
+    std::vector<int> queue;
+    std::vector<char> queued(placed.begin(), placed.end());
+    double center_x = 0.0, center_y = 0.0;
+    int known = 0;
+    for (int v = 0; v < n; ++v) {
+        if (!placed[v]) continue;
+        center_x += positions[v].x;
+        center_y += positions[v].y;
+        known++;
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (!queued[*it]) {
+                queued[*it] = 1;
+                queue.push_back(*it);
+            }
+        }
+    }
+    if (known > 0) {
+        center_x /= known;
+        center_y /= known;
+    }
+    float radius = 0.0f;
+    for (int v = 0; v < n; ++v) {
+        if (placed[v]) radius = std::max(radius, (float)hypot(positions[v].x - center_x, positions[v].y - center_y));
+    }
+    radius += 100.0f;
+    int count = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int v = queue[head];
+        float sum_x = 0.0f, sum_y = 0.0f;
+        int neighbors = 0;
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (placed[*it]) {
+                sum_x += positions[*it].x;
+                sum_y += positions[*it].y;
+                neighbors++;
+            } else if (!queued[*it]) {
+                queued[*it] = 1;
+                queue.push_back(*it);
+            }
+        }
+        positions[v].x = sum_x / neighbors + 50.0f * (rng.uniform() - 0.5f);
+        positions[v].y = sum_y / neighbors + 50.0f * (rng.uniform() - 0.5f);
+        placed[v] = 1;
+        count++;
+    }
+    for (int v = 0; v < n; ++v) {
+        if (placed[v]) continue;
+        float angle = 6.2831853f * rng.uniform();
+        positions[v] = ImVec2(float(center_x + radius * cosf(angle)), float(center_y + radius * sinf(angle)));
+        placed[v] = 1;
+        count++;
+    }
+    return count;
+}
+
+// PlaceNearNeighbors for nodes [first_new, n) appended to a placed graph. Only they and their links are visited,
+// and pieces with no placed node go on a circle of `radius` around `center`. position(v) is the ImVec2& of v.
+template <typename PositionFn>
+int PlaceAppendedNodes(const CSRGraph& g, int first_new, PositionFn position, ImVec2 center, float radius, Pcg32& rng) {
+    int n = g.numNodes();
+    std::vector<char> placed(n - first_new, 0), queued(n - first_new, 0);
+    std::vector<int> queue;
+    for (int v = first_new; v < n; ++v) {
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (*it >= first_new) continue;
+            queued[v - first_new] = 1;
+            queue.push_back(v);
+            break;
+        }
+    }
+    int count = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int v = queue[head];
+        float sum_x = 0.0f, sum_y = 0.0f;
+        int neighbors = 0;
+        for (const int* it = g.begin(v); it != g.end(v); ++it) {
+            if (*it < first_new || placed[*it - first_new]) {
+                sum_x += position(*it).x;
+                sum_y += position(*it).y;
+                neighbors++;
+            } else if (!queued[*it - first_new]) {
+                queued[*it - first_new] = 1;
+                queue.push_back(*it);
+            }
+        }
+        position(v) = ImVec2(sum_x / neighbors + 50.0f * (rng.uniform() - 0.5f),
+                             sum_y / neighbors + 50.0f * (rng.uniform() - 0.5f));
+        placed[v - first_new] = 1;
+        count++;
+    }
+    for (int v = first_new; v < n; ++v) {
+        if (placed[v - first_new]) continue;
+        float angle = 6.2831853f * rng.uniform();
+        position(v) = ImVec2(center.x + radius * cosf(angle), center.y + radius * sinf(angle));
+        count++;
+    }
+    return count;
+}
+
+// Positions for `labels` from a layout cache: cached ones where the label is known, the rest next to their
+// neighbors. Fails when the cache is missing or shares no label with the graph.
+bool RestoreLayout(const std::string& filename, const std::vector<std::string>& labels, const CSRGraph& g,
+                   uint64_t graph_hash, Pcg32& rng, std::vector<ImVec2>& positions) {
+    LayoutCache cache;
+    if (!ReadLayoutCache(filename, cache)) return false;
+    int n = labels.size();
+    positions.assign(n, ImVec2(0.0f, 0.0f));
+    std::vector<char> placed(n, 0);
+    int known = 0;
+    for (int i = 0; i < n; i++) {
+        auto it = cache.positions.find(labels[i]);
+        if (it == cache.positions.end()) continue;
+        positions[i] = it->second;
+        placed[i] = 1;
+        known++;
+    }
+    if (known == 0) return false;
+    int added = PlaceNearNeighbors(g, positions, placed, rng);
+    std::cout << "Restored " << known << " node positions from " << filename;
+    if (cache.graph_hash == graph_hash) std::cout << " (graph unchanged)" << std::endl;
+    else std::cout << ", placed " << added << " new nodes next to their neighbors" << std::endl;
+    return true;
+}
+
+bool BoxesOverlap(ImVec2 lo_a, ImVec2 hi_a, ImVec2 lo_b, ImVec2 hi_b) {
+    return lo_a.x <= hi_b.x && lo_b.x <= hi_a.x && lo_a.y <= hi_b.y && lo_b.y <= hi_a.y;
+}
+
+// Liang-Barsky: clips the segment ab against each slab of the box and checks that something is left
+bool SegmentIntersectsBox(ImVec2 a, ImVec2 b, ImVec2 lo, ImVec2 hi) {
+    float start[2] = {a.x, a.y}, delta[2] = {b.x - a.x, b.y - a.y};
+    float mins[2] = {lo.x, lo.y}, maxs[2] = {hi.x, hi.y};
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int axis = 0; axis < 2; axis++) {
+        if (delta[axis] == 0.0f) {
+            if (start[axis] < mins[axis] || start[axis] > maxs[axis]) return false;
+            continue;
+        }
+        float enter = (mins[axis] - start[axis]) / delta[axis], leave = (maxs[axis] - start[axis]) / delta[axis];
+        if (enter > leave) std::swap(enter, leave);
+        t0 = std::max(t0, enter);
+        t1 = std::min(t1, leave);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+// Uniform grids over node positions and edge segments, so a frame only looks at what is near the view. A node
+// sits in the cell of its center. An edge sits in every cell its segment crosses, on the finest of a stack of
+// ever coarser grids where that is at most kMaxEdgeCells cells, so long links cost no more than short ones.
+// Queries give candidates in ascending index order, which keeps the drawing order of the unculled loops.
+// While the layout moves nodes the index is kept and queries widen by the farthest any node has moved since
+// it was built: a segment whose ends moved at most that far stays within that distance of where it was
+// indexed. It is rebuilt once that drift passes a finest cell.
+class ViewportIndex {
+public:
+    void build(const std::vector<Node>& nodes, const std::vector<Edge>& edges) {
+        int n = nodes.size();
+        levels.clear();
+        edge_stamp.assign(edges.size(), 0);
+        stamp = 0;
+        drift = 0.0f;
+        indexed_positions.resize(n);
+        for (int i = 0; i < n; i++) indexed_positions[i] = nodes[i].position;
+        if (n == 0) return;
+
+        ImVec2 lo = nodes[0].position, hi = lo;
+        for (const auto& node : nodes) {
+            lo = ImVec2(std::min(lo.x, node.position.x), std::min(lo.y, node.position.y));
+            hi = ImVec2(std::max(hi.x, node.position.x), std::max(hi.y, node.position.y));
+        }
+        bounds_lo = lo;
+        bounds_hi = hi;
+        float width = hi.x - lo.x + 1.0f, height = hi.y - lo.y + 1.0f;
+        float cell_size = std::max(kMinCellSize, sqrtf(width * height / n));
+        do {
+            Grid grid;
+            grid.min_x = lo.x;
+            grid.min_y = lo.y;
+            grid.cell_size = cell_size;
+            grid.cols = (int)(width / cell_size) + 1;
+            grid.rows = (int)(height / cell_size) + 1;
+            grid.start.assign(grid.cols * grid.rows + 1, 0);
+            levels.push_back(grid);
+            cell_size *= kLevelScale;
+        } while (levels.back().cols + levels.back().rows > kMaxEdgeCells);
+
+        // Nodes: counting sort by cell of the finest grid, filled in index order so every cell lists its nodes ascending
+        const Grid& finest = levels[0];
+        int cells = finest.cols * finest.rows;
+        node_start.assign(cells + 1, 0);
+        for (const auto& node : nodes) node_start[finest.cellIndex(node.position) + 1]++;
+        for (int c = 0; c < cells; c++) node_start[c + 1] += node_start[c];
+        node_items.resize(n);
+        std::vector<int> next(node_start.begin(), node_start.end() - 1);
+        for (int i = 0; i < n; i++) node_items[next[finest.cellIndex(nodes[i].position)]++] = i;
+
+        // Edges: count the cells of every segment on its level, then fill them the same way
+        std::vector<int> edge_level(edges.size());
+        for (int e = 0; e < (int)edges.size(); e++) {
+            ImVec2 a = nodes[edges[e].from].position, b = nodes[edges[e].to].position;
+            int level = 0;
+            while (level + 1 < (int)levels.size() && levels[level].span(a, b) > kMaxEdgeCells) level++;
+            edge_level[e] = level;
+            Grid& grid = levels[level];
+            grid.forEachSegmentCell(a, b, [&](int cell) { grid.start[cell + 1]++; });
+        }
+        for (Grid& grid : levels) {
+            for (int c = 0; c + 1 < (int)grid.start.size(); c++) grid.start[c + 1] += grid.start[c];
+            grid.items.resize(grid.start.back());
+            grid.next.assign(grid.start.begin(), grid.start.end() - 1);
+        }
+        for (int e = 0; e < (int)edges.size(); e++) {
+            Grid& grid = levels[edge_level[e]];
+            grid.forEachSegmentCell(nodes[edges[e].from].position, nodes[edges[e].to].position,
+                                    [&](int cell) { grid.items[grid.next[cell]++] = e; });
+        }
+    }
+
+    // For positions that moved since build(): measures how far, and rebuilds only when that is over a cell
+    void update(const std::vector<Node>& nodes, const std::vector<Edge>& edges) {
+        if (nodes.size() != indexed_positions.size() || edges.size() != edge_stamp.size()) {
+            build(nodes, edges);
+            return;
+        }
+        float drift_sq = 0.0f;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            float dx = nodes[i].position.x - indexed_positions[i].x, dy = nodes[i].position.y - indexed_positions[i].y;
+            drift_sq = std::max(drift_sq, dx * dx + dy * dy);
+        }
+        drift = sqrtf(drift_sq);
+        if (!levels.empty() && drift > levels[0].cell_size) build(nodes, edges);
+    }
+
+    // Box around the indexed nodes, widened by how far they may have moved since; false when there are none
+    bool bounds(ImVec2& lo, ImVec2& hi) const {
+        if (levels.empty()) return false;
+        lo = bounds_lo;
+        hi = bounds_hi;
+        widen(lo, hi);
+        return true;
+    }
+
+    // Nodes in the cells overlapping [lo, hi]
+    void queryNodes(ImVec2 lo, ImVec2 hi, std::vector<int>& out) const {
+        out.clear();
+        if (levels.empty()) return;
+        widen(lo, hi);
+        const Grid& finest = levels[0];
+        int first_col, last_col, first_row, last_row;
+        if (!finest.cellRange(lo, hi, first_col, last_col, first_row, last_row)) return;
+        for (int r = first_row; r <= last_row; r++) {
+            out.insert(out.end(), node_items.begin() + node_start[r * finest.cols + first_col],
+                       node_items.begin() + node_start[r * finest.cols + last_col + 1]);
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    // Edges with a piece in the cells overlapping [lo, hi]
+    void queryEdges(ImVec2 lo, ImVec2 hi, std::vector<int>& out) {
+        out.clear();
+        if (++stamp == 0) {
+            std::fill(edge_stamp.begin(), edge_stamp.end(), 0);
+            stamp = 1;
+        }
+        widen(lo, hi);
+        for (const Grid& grid : levels) {
+            int first_col, last_col, first_row, last_row;
+            if (!grid.cellRange(lo, hi, first_col, last_col, first_row, last_row)) continue;
+            for (int r = first_row; r <= last_row; r++) {
+                for (int k = grid.start[r * grid.cols + first_col]; k < grid.start[r * grid.cols + last_col + 1]; k++) {
+                    int e = grid.items[k];
+                    if (edge_stamp[e] == stamp) continue;
+                    edge_stamp[e] = stamp;
+                    out.push_back(e);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+private:
+    static constexpr float kMinCellSize = 64.0f;
+    static constexpr float kLevelScale = 8.0f;
+    static constexpr int kMaxEdgeCells = 16;
+
+    struct Grid {
+        float min_x = 0, min_y = 0, cell_size = 1;
+        int cols = 0, rows = 0;
+        std::vector<int> start, items; // cells + 1 offsets, edge ids by cell
+        std::vector<int> next;         // fill cursors while building
+
+        int column(float x) const { return std::min(cols - 1, std::max(0, (int)std::floor((x - min_x) / cell_size))); }
+        int row(float y) const { return std::min(rows - 1, std::max(0, (int)std::floor((y - min_y) / cell_size))); }
+        int cellIndex(ImVec2 p) const { return row(p.y) * cols + column(p.x); }
+
+        // Upper bound on the cells a segment crosses
+        int span(ImVec2 a, ImVec2 b) const { return std::abs(column(a.x) - column(b.x)) + std::abs(row(a.y) - row(b.y)) + 1; }
+
+        // Visits every cell the segment passes through, column by column, with a little slack against rounding
+        template <typename Fn>
+        void forEachSegmentCell(ImVec2 a, ImVec2 b, Fn fn) const {
+            if (a.x > b.x) std::swap(a, b);
+            float slope = b.x > a.x ? (b.y - a.y) / (b.x - a.x) : 0.0f;
+            float slack = 1e-3f * cell_size;
+            for (int c = column(a.x); c <= column(b.x); c++) {
+                float from_x = std::max(a.x, min_x + c * cell_size), to_x = std::min(b.x, min_x + (c + 1) * cell_size);
+                float from_y = a.y, to_y = b.y;
+                if (b.x > a.x) {
+                    from_y = a.y + slope * (from_x - a.x);
+                    to_y = a.y + slope * (to_x - a.x);
+                }
+                int first_row = row(std::min(from_y, to_y) - slack), last_row = row(std::max(from_y, to_y) + slack);
+                for (int r = first_row; r <= last_row; r++) fn(r * cols + c);
+            }
+        }
+
+        // Clamped cell bounds of [lo, hi]; false when the box misses the grid
+        bool cellRange(ImVec2 lo, ImVec2 hi, int& first_col, int& last_col, int& first_row, int& last_row) const {
+            if (hi.x < min_x || hi.y < min_y || lo.x > min_x + cols * cell_size || lo.y > min_y + rows * cell_size) return false;
+            first_col = column(lo.x);
+            last_col = column(hi.x);
+            first_row = row(lo.y);
+            last_row = row(hi.y);
+            return true;
+        }
+    };
+
+    std::vector<Grid> levels;            // finest first; the coarsest is at most kMaxEdgeCells across
+    std::vector<int> node_start, node_items; // on the finest grid
+    std::vector<unsigned> edge_stamp;    // query that last returned each edge
+    unsigned stamp = 0;
+    std::vector<ImVec2> indexed_positions; // node positions the grids were built from
+    ImVec2 bounds_lo, bounds_hi;           // of indexed_positions
+    float drift = 0.0f;                  // farthest any node has moved from them
+
+    void widen(ImVec2& lo, ImVec2& hi) const {
+        lo = ImVec2(lo.x - drift, lo.y - drift);
+        hi = ImVec2(hi.x + drift, hi.y + drift);
+    }
+};
+
+// Everything the summary derives from the graph's structure. It reads only the graphs it is given, so it can
+// be computed from copies on a background thread while the UI keeps drawing.
+struct GraphAnalysis {
+    std::map<int, float> page_rank_scores;
+    std::vector<int> page_rank_order;      // nodes by descending score, for the summary table
+    float page_rank_average = 0.0f;
+    float page_rank_std_dev = 0.0f;
+    TriangleStats triangle_stats;
+    std::vector<float> clustering_coefficients;
+    std::vector<int> clustering_order;     // nodes by descending coefficient
+    float average_clustering = 0.0f;
+    BiconnectivityResult biconnectivity;
+    SCCResult scc;                         // of the directed graph over the chosen relations
+    TopologicalLevels dependency_levels;   // over the SCC condensation
+    std::vector<int> dependency_depth;     // per node, the depth of its component
+    std::vector<int> depth_order;          // nodes by descending depth
+    ReachabilityIndex reachability;
+
+    void calculatePageRank(const CSRGraph& g) {
+        int n = g.numNodes();
+        if (n == 0) return;
+
+        float damping_factor = 0.85f;
+        std::vector<float> current_ranks(n, 1.0f / n), new_ranks(n);
+        for (int iter = 0; iter < 20; ++iter) {
+            std::fill(new_ranks.begin(), new_ranks.end(), 1.0f - damping_factor);
+            for (int i = 0; i < n; ++i) {
+                for (const int* neighbor = g.begin(i); neighbor != g.end(i); ++neighbor) {
+                    new_ranks[*neighbor] += damping_factor * (current_ranks[i] / g.degree(i));
+                }
+            }
+            current_ranks.swap(new_ranks);
+        }
+
+        float sum = 0.0f;
+        for (float rank : current_ranks) sum += rank;
+        page_rank_average = sum / n;
+
+        float variance_sum = 0.0f;
+        for (float rank : current_ranks) variance_sum += pow(rank - page_rank_average, 2);
+        page_rank_std_dev = sqrt(variance_sum / n);
 
-// Data Structures
-struct Node {
-    ImVec2 position;
-    std::string label;
-    bool selected = false;
-    bool dragging = false;
-    ImVec2 drag_offset;
-    float radius;
-    int connection_count = 0;
-};
+        page_rank_scores.clear();
+        for (int i = 0; i < n; ++i) page_rank_scores.emplace_hint(page_rank_scores.end(), i, current_ranks[i]);
+        page_rank_order = OrderByDescending(current_ranks);
+    }
 
-struct Edge {
-    int from, to;
-    std::string predicate;
-};
+    // Local clustering coefficient: the fraction of a node's neighbor pairs that are themselves linked.
+    // Pass a sample_rate below 1 on very large graphs to estimate from a subset of incident edges.
+    void calculateClustering(const CSRGraph& g, float sample_rate = 1.0f) {
+        int n = g.numNodes();
+        triangle_stats = CountTriangles(g, sample_rate);
+        clustering_coefficients.assign(n, 0.0f);
+        if (n == 0) return;
 
-// Struct for raw data from file
-struct Triple {
-    std::string node_name;
-    std::string edge_name;
-    std::string name_of_component;
-    std::string severity;
-};
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            int degree = g.degree(i);
+            if (degree > 1) {
+                float coefficient = static_cast<float>(2.0 * triangle_stats.per_node[i] / (static_cast<double>(degree) * (degree - 1)));
+                clustering_coefficients[i] = std::min(coefficient, 1.0f);
+            }
+            sum += clustering_coefficients[i];
+        }
+        average_clustering = sum / n;
+        clustering_order = OrderByDescending(clustering_coefficients);
+    }
 
-// Helper function to convert severity to a numerical weight with more variability
-float severityToWeight(const std::string& severity) {
-    if (severity == "high") return 0.8f;
-    if (severity == "medium") return 0.4f;
-    if (severity == "low") return 0.1f;
-    return 0.0f;
-}
+    // Indices of values from largest to smallest, ties in index order
+    template <typename T>
+    static std::vector<int> OrderByDescending(const std::vector<T>& values) {
+        std::vector<int> order(values.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return values[a] > values[b]; });
+        return order;
+    }
+
+    // Nodes and links whose removal disconnects part of the graph
+    void calculateBiconnectivity(const CSRGraph& g) {
+        if (g.numNodes() >= (1 << 16) && WorkerCount() > 1) {
+            biconnectivity = ComputeBiconnectivityParallel(g);
+        } else {
+            biconnectivity = ComputeBiconnectivity(g);
+        }
+    }
+
+    // Strongly connected components of the dependency graph (any with more than one node is a cycle), the
+    // longest dependency chain above each node with cycles collapsed first, and the reachability index
+    void calculateDependencies(const CSRGraph& dependency_out, const CSRGraph& dependency_in) {
+        int n = dependency_out.numNodes();
+        if (n >= (1 << 16) && WorkerCount() > 1) {
+            scc = StronglyConnectedComponentsParallel(dependency_out, dependency_in);
+        } else {
+            scc = StronglyConnectedComponents(dependency_out);
+        }
+        dependency_levels = TopologicalSort(scc.condensation);
+        dependency_depth.assign(n, 0);
+        for (int i = 0; i < n; ++i) dependency_depth[i] = dependency_levels.depth[scc.component[i]];
+        depth_order = OrderByDescending(dependency_depth);
+        reachability.build(scc, dependency_levels);
+    }
+
+    void clearDependencies() {
+        takeDependencies(GraphAnalysis());
+    }
 
+    void takeDependencies(GraphAnalysis&& other) {
+        scc = std::move(other.scc);
+        dependency_levels = std::move(other.dependency_levels);
+        dependency_depth = std::move(other.dependency_depth);
+        depth_order = std::move(other.depth_order);
+        reachability = std::move(other.reachability);
+    }
+};
+
+#ifndef GRAPH_HEADLESS
 class GraphVisualizer {
 private:
     std::vector<Node> nodes;
     std::vector<Edge> edges;
-    std::vector<std::vector<float>> adjacency_matrix;
     std::vector<std::set<int>> adjacency_list;
-    std::map<int, float> page_rank_scores;
+    std::map<std::string, int> node_index; // label -> index into nodes
+    std::vector<Triple> loaded_triples;    // what the graph was built from, to tell appends from edits
     int selected_node = -1;
-    std::vector<ImVec2> velocities;
     ImVec2 pan_offset = ImVec2(0.0f, 0.0f);
     bool is_panning = false;
     ImVec2 pan_drag_start_screen = ImVec2(0,0);
     ImVec2 pan_offset_start = ImVec2(0,0);
+    // Viewport culling: the index is rebuilt when the graph or its whole layout changes and follows the
+    // simulation by widening queries (see ViewportIndex); label sizes are measured once per node and link
+    ViewportIndex view_index;
+    bool view_index_stale = true;
+    bool view_index_moved = false; // positions changed a little since the last frame
+    std::vector<ImVec2> node_label_size, edge_label_size;
+    ImVec2 node_label_extent, edge_label_extent; // largest half sizes
+    std::vector<int> candidate_nodes, candidate_edges;
+    int drawn_nodes = 0, drawn_edges = 0;
+    int max_connections = 0;
     ImFont* large_font = nullptr;
-    float page_rank_average = 0.0f;
-    float page_rank_std_dev = 0.0f;
+    CSRGraph csr;
+    CSRGraph outgoing_edges; // per node, ids into `edges` of the triples it is the subject of
+    EgoNetworkExtractor ego_extractor;
+    Subgraph focus;
+    std::vector<char> in_focus;
+    bool focus_active = false;
+    int focus_hops = 2;
+    std::vector<std::string> predicates;   // distinct edge predicates, for the dependency filter
+    int dependency_predicate = 0;          // 0 = all relations, otherwise predicates[index - 1]
+    CSRGraph dependency_out, dependency_in; // directed subject -> object graph over the chosen relations
+    GraphAnalysis analysis;
+    std::vector<std::string> cycle_listing; // members of each cycle, joined whenever analysis.scc changes
+    bool physics_enabled = true;
+    int impact_source = -1;          // node the impact list was computed for
+    std::vector<int> impact_nodes;   // everything downstream of impact_source
+    std::vector<char> in_impact;
+    double impact_query_us = 0.0;
+    bool highlight_impact = true;
+    // What-if removal: nodes and links masked out of connectivity and PageRank without rebuilding anything
+    bool what_if_active = false;
+    std::vector<char> removed_nodes;
+    std::vector<char> removed_slots;   // csr slots, both directions of a removed link
+    BFSEngine what_if_bfs;
+    ComponentLabels base_components, what_if_components;
+    std::vector<int> free_component_ids; // what-if ids left empty by a relabel, reused before new ones
+    CSRGraph component_members;        // nodes of each base component
+    std::vector<float> base_rank, what_if_rank;
+    int what_if_rank_iterations = 0;
+    double what_if_ms = 0.0;
+    int base_component_count = 0, base_largest = 0, what_if_component_count = 0, what_if_largest = 0;
+    std::vector<int> what_if_shifted;  // the nodes whose PageRank moved most, largest shift first
+    std::vector<std::vector<int>> cliques;
+    std::vector<char> clique_systemic; // every member is flagged by a high-severity triple
+    int clique_min_size = 3;
+    float clique_budget_ms = 200.0f;
+    bool cliques_complete = true;
+    std::shared_ptr<const std::vector<float>> simrank_matrix; // all pairs, only for graphs up to kExactSimRankNodes
+    int simrank_source = -1;           // selection the similar nodes are (being) computed for
+    std::vector<std::pair<int, float>> similar_nodes;
+    // Filled in by simrank_thread; SyncSimilarity takes it if neither the graph nor the selection changed since
+    struct SimilarityResult {
+        std::mutex mutex;
+        int source = -1;
+        unsigned graph_version = 0;
+        std::vector<std::pair<int, float>> similar;
+        std::shared_ptr<const std::vector<float>> matrix; // computed by the job if it was missing
+        bool done = false;
+    };
+    std::shared_ptr<SimilarityResult> simrank_result; // the job in flight, null when there is none
+    std::thread simrank_thread;
+    unsigned graph_version = 0;        // bumped whenever node indices may change meaning
+    LayoutEngine::Settings layout_settings;
+    LayoutThread layout;
+    unsigned long long layout_barrier = 0; // older snapshots predate positions set from the UI
+    ImVec2 layout_center;                  // where the engine's gravity pulls
+    double physics_step_ms = 0.0;
+    bool physics_settled = false;
+    uint64_t layout_seed = 1;
+    Pcg32 layout_rng;
+    static constexpr float kMinNodeRadius = 15.0f;
+    static constexpr float kMaxNodeRadius = 40.0f;
+    // Typed graphs this large open in the layered layout, computed in one pass, instead of the simulation
+    static constexpr int kLayeredDefaultNodes = 5000;
+    std::string layout_cache_path; // empty: positions are not saved between runs
+    uint64_t graph_hash = 0;
+    // Filled in by the layout thread when a stress refinement finishes
+    struct StressResult {
+        std::mutex mutex;
+        StressReport report;
+        bool done = false;
+    };
+    std::shared_ptr<StressResult> stress_result = std::make_shared<StressResult>();
+    // Filled in by analysis_thread from copies of the adjacency; SyncAnalysis moves it into `analysis`
+    struct AnalysisResult {
+        std::mutex mutex;
+        GraphAnalysis analysis;
+        bool dependencies_only = false; // only the dependency fields were recomputed
+        bool done = false;
+    };
+    std::shared_ptr<AnalysisResult> analysis_result; // the job in flight, null when there is none
+    std::thread analysis_thread;
+    bool analysis_queued = false;      // the graph changed again while a job was running
+    bool queued_dependencies_only = false;
 
 public:
-    GraphVisualizer() {
-        srand(static_cast<unsigned int>(time(0)));
+    GraphVisualizer() {}
+
+    ~GraphVisualizer() {
+        if (analysis_thread.joinable()) analysis_thread.join();
+        if (simrank_thread.joinable()) simrank_thread.join();
+    }
+
+    // Initial and reset placements draw from this seed, so the same data always lays out the same way
+    void setLayoutSeed(uint64_t seed) {
+        layout_seed = seed;
+    }
+
+    // Where node positions are restored from on load and saved to by saveLayoutCache()
+    void setLayoutCachePath(const std::string& path) {
+        layout_cache_path = path;
     }
 
     void setLargeFont(ImFont* font) {
@@ -76,53 +4159,205 @@ public:
     }
 
     void LoadTriples(const std::vector<Triple>& triples) {
-        nodes.clear();
-        edges.clear();
-        velocities.clear();
-        selected_node = -1;
-        pan_offset = ImVec2(0.0f, 0.0f);
-        page_rank_scores.clear();
-
-        std::map<std::string, int> node_map;
-        int next_node_index = 0;
+        buildGraph(triples);
+        if (!restoreCachedLayout()) {
+            if (hasNodeTypes() && (int)nodes.size() >= kLayeredDefaultNodes && placeLayered(false)) physics_enabled = false;
+            else placeInitialLayout();
+        }
+        restartLayout();
+        startAnalysis();
+    }
 
-        for (const auto& triple : triples) {
-            if (node_map.find(triple.node_name) == node_map.end()) {
-                node_map[triple.node_name] = next_node_index++;
-                Node node;
-                node.label = triple.node_name;
-                nodes.push_back(node);
+    // Switches to a newer version of the data without disturbing the drawing: known nodes keep their places,
+    // new ones start next to their neighbors and only they and those neighbors are simulated. When the file only
+    // grew, the new triples are added to the current graph in place: its structures, the content hash and the
+    // running simulation are extended, and the nearby nodes come from the viewport index, so that part costs
+    // the size of the update. Reading the file and telling an append from an edit still take a pass over it, the
+    // analyses are redone in full on their thread, and the viewport index is rebuilt on the next frame.
+    void UpdateTriples(const std::vector<Triple>& triples) {
+        if (nodes.empty()) {
+            LoadTriples(triples);
+            return;
+        }
+        if (sameStructure(triples)) {
+            updateEdgeAttributes(triples);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        int n_before = nodes.size();
+        bool appended = triples.size() >= loaded_triples.size() &&
+                        std::equal(loaded_triples.begin(), loaded_triples.end(), triples.begin());
+        auto position = [this](int v) -> ImVec2& { return nodes[v].position; };
+        auto nodes_near = [this](ImVec2 lo, ImVec2 hi, std::vector<int>& out) { view_index.queryNodes(lo, hi, out); };
+        std::vector<int> moving;
+        int steps = 0;
+        if (appended) {
+            syncViewIndex(); // over the nodes already placed, which is all SettleLocally asks it about
+            int first_edge = edges.size();
+            resetAnalysisState();
+            appendTriples(triples, loaded_triples.size());
+            extendGraph(n_before, first_edge);
+            for (int v = n_before; v < (int)nodes.size(); v++) moving.push_back(v);
+            ImVec2 lo, hi;
+            float radius = 0.0f;
+            if (view_index.bounds(lo, hi)) {
+                radius = std::max(std::max(hi.x - layout_center.x, layout_center.x - lo.x),
+                                  std::max(hi.y - layout_center.y, layout_center.y - lo.y));
             }
-            if (node_map.find(triple.name_of_component) == node_map.end()) {
-                node_map[triple.name_of_component] = next_node_index++;
-                Node node;
-                node.label = triple.name_of_component;
-                nodes.push_back(node);
+            PlaceAppendedNodes(csr, n_before, position, layout_center, radius + 100.0f, layout_rng);
+            moving = withNeighbors(moving);
+            steps = SettleLocally(csr, moving, position, nodes_near, layout_settings, layout_center);
+            extendLayout(first_edge, moving);
+        } else {
+            bool physics = physics_enabled, was_settled = physics_settled;
+            ImVec2 pan = pan_offset;
+            std::map<std::string, ImVec2> previous;
+            for (const auto& node : nodes) previous[node.label] = node.position;
+            buildGraph(triples);
+            physics_enabled = physics;
+            pan_offset = pan;
+            std::vector<ImVec2> positions;
+            std::vector<char> placed;
+            for (const auto& node : nodes) {
+                auto it = previous.find(node.label);
+                positions.push_back(it != previous.end() ? it->second : ImVec2(0.0f, 0.0f));
+                placed.push_back(it != previous.end());
+                if (it == previous.end()) moving.push_back(positions.size() - 1);
             }
+            PlaceNearNeighbors(csr, positions, placed, layout_rng);
+            setNodePositions(positions);
+            syncViewIndex();
+            moving = withNeighbors(moving);
+            steps = SettleLocally(csr, moving, position, nodes_near, layout_settings, layout_center);
+            view_index_stale = true;
+            restartLayout(was_settled || !physics_enabled, true);
         }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        startAnalysis();
+        int added = nodes.size() - n_before;
+        std::cout << (appended ? "Appended" : "Rebuilt") << ": added " << added << " nodes, settled " << moving.size()
+                  << " around them in " << steps << " steps (" << ms << " ms)" << std::endl;
+    }
 
-        int n = nodes.size();
-        adjacency_matrix.assign(n, std::vector<float>(n, 0.0f));
-        adjacency_list.assign(n, std::set<int>());
-        velocities.assign(n, ImVec2(0, 0));
+    // `added` (ascending) followed by their neighbors that are not in it
+    std::vector<int> withNeighbors(const std::vector<int>& added) const {
+        std::vector<int> neighbors;
+        for (int v : added) {
+            for (const int* it = csr.begin(v); it != csr.end(v); ++it) {
+                if (!std::binary_search(added.begin(), added.end(), *it)) neighbors.push_back(*it);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        std::vector<int> result(added);
+        result.insert(result.end(), neighbors.begin(), neighbors.end());
+        return result;
+    }
 
-        for (int i = 0; i < n; i++) {
-            nodes[i].position = ImVec2(100.0f + (std::rand() % 600), 100.0f + (std::rand() % 400));
+    // Whether `triples` name exactly the current nodes and links, in any order, going by the content hash.
+    // Node indices then stay valid for the new data.
+    bool sameStructure(const std::vector<Triple>& triples) const {
+        std::vector<std::pair<int, int>> links;
+        std::vector<char> seen(nodes.size(), 0);
+        size_t distinct = 0;
+        for (const auto& triple : triples) {
+            auto from = node_index.find(triple.node_name), to = node_index.find(triple.name_of_component);
+            if (from == node_index.end() || to == node_index.end()) return false;
+            for (int v : {from->second, to->second}) {
+                if (!seen[v]) distinct++;
+                seen[v] = 1;
+            }
+            if (from->second != to->second) links.push_back({from->second, to->second});
         }
+        if (distinct != nodes.size() || links.size() != edges.size()) return false;
+        std::vector<std::string> labels;
+        for (const auto& node : nodes) labels.push_back(node.label);
+        return GraphContentHash(labels, links) == graph_hash;
+    }
 
+    // Takes relations, severities and types from a file with the same nodes and links. Positions, the simulation
+    // and the analyses of the undirected graph stay; the dependency results and which cliques are systemic are
+    // recomputed.
+    void updateEdgeAttributes(const std::vector<Triple>& triples) {
+        if (triples == loaded_triples) return;
+        std::string relation = dependency_predicate > 0 ? predicates[dependency_predicate - 1] : "";
         for (auto& node : nodes) {
+            node.type.clear();
             node.connection_count = 0;
         }
+        edges.clear();
+        edge_label_size.clear();
+        loaded_triples.clear();
+        appendTriples(triples, 0);
+        std::set<std::string> distinct_predicates;
+        for (const auto& edge : edges) distinct_predicates.insert(edge.predicate);
+        auto it = distinct_predicates.find(relation);
+        dependency_predicate = it != distinct_predicates.end() ? (int)std::distance(distinct_predicates.begin(), it) + 1 : 0;
+        finishGraph();
+        updateCliqueSystemic();
+        analysis.clearDependencies();
+        cycle_listing.clear();
+        startAnalysis(true);
+        std::cout << "Graph unchanged: kept the layout, updated " << edges.size() << " links" << std::endl;
+    }
 
-        for (const auto& triple : triples) {
-            int from_idx = node_map[triple.node_name];
-            int to_idx = node_map[triple.name_of_component];
-            if (from_idx != to_idx) {
-                edges.push_back({from_idx, to_idx, triple.edge_name});
-                float weight = severityToWeight(triple.severity);
-                adjacency_matrix[from_idx][to_idx] = weight;
-                adjacency_matrix[to_idx][from_idx] = weight;
+    void buildGraph(const std::vector<Triple>& triples) {
+        nodes.clear();
+        edges.clear();
+        adjacency_list.clear();
+        node_index.clear();
+        loaded_triples.clear();
+        node_label_size.clear();
+        edge_label_size.clear();
+        pan_offset = ImVec2(0.0f, 0.0f);
+        physics_enabled = true;
+        selected_node = -1;
+        resetAnalysisState();
+        appendTriples(triples, 0);
+        finishGraph();
+    }
+
+    // Drops everything computed from the previous version of the graph
+    void resetAnalysisState() {
+        layout_rng = Pcg32(layout_seed);
+        focus = Subgraph();
+        focus_active = false;
+        analysis = GraphAnalysis();
+        cycle_listing.clear();
+        impact_source = -1;
+        impact_nodes.clear();
+        what_if_active = false;
+        cliques.clear();
+        clique_systemic.clear();
+        simrank_matrix.reset();
+        simrank_source = -1;
+        similar_nodes.clear();
+        graph_version++;
+        dependency_predicate = 0;
+        stress_result = std::make_shared<StressResult>();
+    }
+
+    int nodeIndex(const std::string& label) {
+        auto inserted = node_index.emplace(label, (int)nodes.size());
+        if (inserted.second) {
+            Node node;
+            node.label = label;
+            nodes.push_back(node);
+            adjacency_list.emplace_back();
+        }
+        return inserted.first->second;
+    }
 
+    // Adds triples[first..] to the graph; names not seen before become new nodes at the end
+    void appendTriples(const std::vector<Triple>& triples, size_t first) {
+        for (size_t t = first; t < triples.size(); ++t) {
+            const Triple& triple = triples[t];
+            int from_idx = nodeIndex(triple.node_name);
+            int to_idx = nodeIndex(triple.name_of_component);
+            if (nodes[from_idx].type.empty()) nodes[from_idx].type = triple.subject_type;
+            if (nodes[to_idx].type.empty()) nodes[to_idx].type = triple.object_type;
+            if (from_idx != to_idx) {
+                edges.push_back({from_idx, to_idx, triple.edge_name, triple.severity});
                 adjacency_list[from_idx].insert(to_idx);
                 adjacency_list[to_idx].insert(from_idx);
                 
@@ -130,77 +4365,510 @@ public:
                 nodes[to_idx].connection_count++;
             }
         }
+        loaded_triples.insert(loaded_triples.end(), triples.begin() + first, triples.end());
+    }
 
-        int max_connections = 0;
+    // Rebuilds the flat structures over nodes and edges; linear passes, no lookups by name
+    void finishGraph() {
+        int n = nodes.size();
+        csr = BuildCSR(adjacency_list);
+        std::vector<std::string> labels;
+        for (const auto& node : nodes) labels.push_back(node.label);
+        graph_hash = GraphContentHash(labels, springPairs());
+
+        outgoing_edges.offsets.assign(n + 1, 0);
+        for (const auto& edge : edges) outgoing_edges.offsets[edge.from + 1]++;
+        for (int i = 0; i < n; i++) outgoing_edges.offsets[i + 1] += outgoing_edges.offsets[i];
+        outgoing_edges.neighbors.resize(edges.size());
+        std::vector<int> fill(outgoing_edges.offsets.begin(), outgoing_edges.offsets.end() - 1);
+        for (int e = 0; e < (int)edges.size(); e++) outgoing_edges.neighbors[fill[edges[e].from]++] = e;
+
+        std::set<std::string> distinct_predicates;
+        for (const auto& edge : edges) distinct_predicates.insert(edge.predicate);
+        predicates.assign(distinct_predicates.begin(), distinct_predicates.end());
+        buildDependencyGraph();
+
+        max_connections = 0;
         for (const auto& node : nodes) {
             if (node.connection_count > max_connections) {
                 max_connections = node.connection_count;
             }
         }
 
-        for (auto& node : nodes) {
-            if (max_connections > 0) {
-                node.radius = 25.0f + 25.0f * (static_cast<float>(node.connection_count) / max_connections);
+        for (auto& node : nodes) setNodeRadius(node);
+        view_index_stale = true;
+    }
+
+    void setNodeRadius(Node& node) const {
+        float normalized_connections = max_connections > 0 ? static_cast<float>(node.connection_count) / max_connections : 0.0f;
+        node.radius = kMinNodeRadius + (kMaxNodeRadius - kMinNodeRadius) * normalized_connections;
+    }
+
+    // finishGraph for the nodes and edges appended from first_node and first_edge on. Every structure grows by
+    // what was added, so this costs the update plus moving the CSR rows after the lowest one it touches; only
+    // when the largest connection count grows are all radii redone.
+    void extendGraph(int first_node, int first_edge) {
+        int n = nodes.size(), m = edges.size();
+        std::vector<std::pair<int, int>> links, outgoing;
+        for (int v = first_node; v < n; v++) graph_hash += LabelHashTerm(LabelFingerprint(nodes[v].label));
+        for (int e = first_edge; e < m; e++) {
+            const Edge& edge = edges[e];
+            links.push_back({edge.from, edge.to});
+            links.push_back({edge.to, edge.from});
+            outgoing.push_back({edge.from, e});
+            graph_hash += LinkHashTerm(LabelFingerprint(nodes[edge.from].label), LabelFingerprint(nodes[edge.to].label));
+        }
+        InsertIntoCSR(csr, n, links);
+        InsertIntoCSR(outgoing_edges, n, outgoing);
+
+        // New relations are inserted in order; the chosen one is found again by name
+        std::string relation = dependency_predicate > 0 ? predicates[dependency_predicate - 1] : "";
+        for (int e = first_edge; e < m; e++) {
+            auto it = std::lower_bound(predicates.begin(), predicates.end(), edges[e].predicate);
+            if (it == predicates.end() || *it != edges[e].predicate) predicates.insert(it, edges[e].predicate);
+        }
+        if (!relation.empty()) {
+            dependency_predicate = std::lower_bound(predicates.begin(), predicates.end(), relation) - predicates.begin() + 1;
+        }
+        std::vector<std::pair<int, int>> out, in;
+        for (int e = first_edge; e < m; e++) {
+            if (!isDependencyEdge(edges[e])) continue;
+            out.push_back({edges[e].from, edges[e].to});
+            in.push_back({edges[e].to, edges[e].from});
+        }
+        InsertIntoCSR(dependency_out, n, out);
+        InsertIntoCSR(dependency_in, n, in);
+
+        int largest = max_connections;
+        for (int e = first_edge; e < m; e++) {
+            largest = std::max({largest, nodes[edges[e].from].connection_count, nodes[edges[e].to].connection_count});
+        }
+        if (largest != max_connections) {
+            max_connections = largest;
+            for (auto& node : nodes) setNodeRadius(node);
+        } else {
+            for (int v = first_node; v < n; v++) setNodeRadius(nodes[v]);
+            for (int e = first_edge; e < m; e++) {
+                setNodeRadius(nodes[edges[e].from]);
+                setNodeRadius(nodes[edges[e].to]);
+            }
+        }
+        view_index_stale = true;
+    }
+
+    bool isDependencyEdge(const Edge& edge) const {
+        return dependency_predicate == 0 || edge.predicate == predicates[dependency_predicate - 1];
+    }
+
+    void buildDependencyGraph() {
+        std::vector<std::pair<int, int>> links, reversed;
+        for (const auto& edge : edges) {
+            if (!isDependencyEdge(edge)) continue;
+            links.push_back({edge.from, edge.to});
+            reversed.push_back({edge.to, edge.from});
+        }
+        dependency_out = BuildCSRFromEdges(nodes.size(), links, false);
+        dependency_in = BuildCSRFromEdges(nodes.size(), reversed, false);
+    }
+
+    // Recomputes the analyses on a background thread; until they land the summary shows the graph without them.
+    // With dependencies_only, only the results that depend on the chosen relation are replaced.
+    void startAnalysis(bool dependencies_only = false) {
+        if (analysis_result) {
+            queued_dependencies_only = analysis_queued ? queued_dependencies_only && dependencies_only : dependencies_only;
+            analysis_queued = true;
+            return;
+        }
+        std::shared_ptr<AnalysisResult> result = std::make_shared<AnalysisResult>();
+        result->dependencies_only = dependencies_only;
+        analysis_result = result;
+        if (analysis_thread.joinable()) analysis_thread.join();
+        analysis_thread = std::thread([result, graph = csr, out = dependency_out, in = dependency_in, dependencies_only] {
+            GraphAnalysis analysis;
+            if (!dependencies_only) {
+                analysis.calculatePageRank(graph);
+                analysis.calculateClustering(graph);
+                analysis.calculateBiconnectivity(graph);
+            }
+            analysis.calculateDependencies(out, in);
+            std::lock_guard<std::mutex> lock(result->mutex);
+            result->analysis = std::move(analysis);
+            result->done = true;
+        });
+    }
+
+    bool analysisPending() const {
+        return analysis_result != nullptr;
+    }
+
+    // Takes a finished analysis, unless the graph changed while it ran; then the newer one is started instead
+    void SyncAnalysis() {
+        if (!analysis_result) return;
+        std::shared_ptr<AnalysisResult> result = analysis_result;
+        {
+            std::lock_guard<std::mutex> lock(result->mutex);
+            if (!result->done) return;
+        }
+        analysis_thread.join();
+        analysis_result = nullptr;
+        if (analysis_queued) {
+            analysis_queued = false;
+            // Whatever the finished job covered is still missing, so the next one covers it too
+            startAnalysis(queued_dependencies_only && result->dependencies_only);
+            return;
+        }
+        if (result->dependencies_only) analysis.takeDependencies(std::move(result->analysis));
+        else analysis = std::move(result->analysis);
+        updateCycleListing();
+        impact_source = -1;
+    }
+
+    void updateCycleListing() {
+        cycle_listing.clear();
+        if (analysis.scc.component.empty()) return;
+        std::vector<std::vector<int>> cycles(analysis.scc.count());
+        for (int i = 0; i < (int)nodes.size(); ++i) {
+            if (analysis.scc.inCycle(i)) cycles[analysis.scc.component[i]].push_back(i);
+        }
+        for (const auto& members : cycles) {
+            if (members.empty()) continue;
+            std::string text;
+            for (int v : members) text += (text.empty() ? "" : ", ") + nodes[v].label;
+            cycle_listing.push_back(std::move(text));
+        }
+    }
+
+    // Everything a failure at node_index can propagate to along the dependency relations
+    void updateImpact(int node_index) {
+        impact_source = node_index;
+        impact_nodes.clear();
+        in_impact.assign(nodes.size(), 0);
+        if (node_index < 0 || analysis.scc.component.empty()) return;
+        auto start = std::chrono::steady_clock::now();
+        impact_nodes = analysis.reachability.reachableFrom(node_index);
+        impact_query_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        for (int v : impact_nodes) in_impact[v] = 1;
+    }
+
+    static constexpr int kExactSimRankNodes = 2000;
+
+    // Nodes with the most similar neighborhoods to node_index by SimRank: exact on small graphs (the matrix is
+    // computed on first use and kept), a Monte Carlo single-source estimate on large ones. Runs on a background
+    // thread; a selection made meanwhile is picked up by SyncSimilarity when the running job ends.
+    void updateSimilarNodes(int node_index) {
+        simrank_source = node_index;
+        similar_nodes.clear();
+        if (node_index < 0 || node_index >= (int)nodes.size() || simrank_result) return;
+        std::shared_ptr<SimilarityResult> result = std::make_shared<SimilarityResult>();
+        result->source = node_index;
+        result->graph_version = graph_version;
+        simrank_result = result;
+        if (simrank_thread.joinable()) simrank_thread.join();
+        simrank_thread = std::thread([result, graph = csr, matrix = simrank_matrix, node_index]() mutable {
+            int n = graph.numNodes();
+            std::vector<float> scores;
+            if (n <= kExactSimRankNodes) {
+                if (!matrix) matrix = std::make_shared<const std::vector<float>>(SimRankExact(graph));
+                scores.assign(matrix->begin() + (size_t)node_index * n, matrix->begin() + (size_t)(node_index + 1) * n);
             } else {
-                node.radius = 25.0f;
+                scores = SimRankSingleSource(graph, node_index);
+            }
+            std::vector<std::pair<int, float>> similar;
+            for (int v = 0; v < n; ++v) {
+                if (v != node_index && scores[v] > 0.0f) similar.push_back({v, scores[v]});
             }
+            std::sort(similar.begin(), similar.end(), [](const std::pair<int, float>& a, const std::pair<int, float>& b) {
+                return a.second > b.second;
+            });
+            if (similar.size() > 10) similar.resize(10);
+            std::lock_guard<std::mutex> lock(result->mutex);
+            result->similar = std::move(similar);
+            result->matrix = matrix;
+            result->done = true;
+        });
+    }
+
+    bool similarityPending() const {
+        return simrank_result != nullptr;
+    }
+
+    void SyncSimilarity() {
+        if (!simrank_result) return;
+        std::shared_ptr<SimilarityResult> result = simrank_result;
+        {
+            std::lock_guard<std::mutex> lock(result->mutex);
+            if (!result->done) return;
         }
+        simrank_thread.join();
+        simrank_result = nullptr;
+        bool current_graph = result->graph_version == graph_version;
+        if (current_graph) simrank_matrix = result->matrix;
+        if (current_graph && result->source == simrank_source) similar_nodes = std::move(result->similar);
+        else updateSimilarNodes(simrank_source);
     }
 
-    void calculatePageRank() {
-        int n = nodes.size();
-        if (n == 0) return;
+    // Maximal cliques of at least clique_min_size, largest first
+    void calculateCliques() {
+        cliques.clear();
+        cliques_complete = EnumerateMaximalCliques(csr, clique_min_size, clique_budget_ms, [&](const std::vector<int>& clique) {
+            cliques.push_back(clique);
+        });
+        std::sort(cliques.begin(), cliques.end(), [](const std::vector<int>& a, const std::vector<int>& b) {
+            return a.size() != b.size() ? a.size() > b.size() : a < b;
+        });
+        for (auto& clique : cliques) std::sort(clique.begin(), clique.end());
+        updateCliqueSystemic();
+    }
 
-        float damping_factor = 0.85f;
-        float initial_rank = 1.0f / n;
-        std::map<int, float> current_ranks;
-        std::map<int, float> new_ranks;
-        std::map<int, int> out_degree;
+    // A clique is systemic when every member has a high-severity link
+    void updateCliqueSystemic() {
+        std::vector<char> flagged(nodes.size(), 0);
+        for (const auto& edge : edges) {
+            if (edge.severity == "high") flagged[edge.from] = flagged[edge.to] = 1;
+        }
+        clique_systemic.clear();
+        for (const auto& clique : cliques) {
+            bool all_flagged = true;
+            for (int v : clique) all_flagged = all_flagged && flagged[v];
+            clique_systemic.push_back(all_flagged);
+        }
+    }
 
-        for (int i = 0; i < n; ++i) {
-            current_ranks[i] = initial_rank;
-            out_degree[i] = adjacency_list[i].size();
+    int linkSlot(int u, int v) const {
+        const int* it = std::lower_bound(csr.begin(u), csr.end(u), v);
+        return (it != csr.end(u) && *it == v) ? (int)(it - csr.neighbors.data()) : -1;
+    }
+
+    bool isRemoved(int node_index) const {
+        return what_if_active && removed_nodes[node_index];
+    }
+
+    bool isLinkRemoved(int u, int v) const {
+        if (!what_if_active) return false;
+        int slot = linkSlot(u, v);
+        return removed_nodes[u] || removed_nodes[v] || (slot >= 0 && removed_slots[slot]);
+    }
+
+    void beginWhatIf() {
+        if (what_if_active) return;
+        int n = nodes.size();
+        removed_nodes.assign(n, 0);
+        removed_slots.assign(csr.neighbors.size(), 0);
+        base_components = ConnectedComponents(csr, what_if_bfs);
+        component_members.offsets.assign(base_components.sizes.size() + 1, 0);
+        for (int c = 0; c < (int)base_components.sizes.size(); ++c) {
+            component_members.offsets[c + 1] = component_members.offsets[c] + base_components.sizes[c];
         }
+        component_members.neighbors.resize(n);
+        std::vector<int> fill(component_members.offsets.begin(), component_members.offsets.end() - 1);
+        for (int v = 0; v < n; ++v) component_members.neighbors[fill[base_components.label[v]]++] = v;
 
-        for (int iter = 0; iter < 20; ++iter) {
-            for (int i = 0; i < n; ++i) {
-                new_ranks[i] = 1.0f - damping_factor;
+        base_rank.assign(n, 1.0f / std::max(n, 1));
+        for (const auto& pair : analysis.page_rank_scores) base_rank[pair.first] = pair.second;
+        base_rank = PageRankWarmStart(csr, base_rank, BFSFilter());
+        what_if_components = base_components;
+        free_component_ids.clear();
+        what_if_rank = base_rank;
+        base_component_count = what_if_component_count = base_components.sizes.size();
+        base_largest = what_if_largest = base_components.sizes.empty() ? 0 : *std::max_element(base_components.sizes.begin(), base_components.sizes.end());
+        what_if_shifted.clear();
+        what_if_active = true;
+    }
+
+    void removeNodeWhatIf(int node_index) {
+        beginWhatIf();
+        removed_nodes[node_index] = 1;
+        updateWhatIf(node_index);
+    }
+
+    void removeLinkWhatIf(int u, int v) {
+        beginWhatIf();
+        int slot = linkSlot(u, v), reverse = linkSlot(v, u);
+        if (slot < 0 || reverse < 0) return;
+        removed_slots[slot] = removed_slots[reverse] = 1;
+        updateWhatIf(u);
+    }
+
+    // Only the base component that contains the change can split, so only its nodes are relabeled.
+    // PageRank restarts from the previous what-if ranks.
+    void updateWhatIf(int touched_node) {
+        auto start = std::chrono::steady_clock::now();
+        BFSFilter filter;
+        filter.removed_nodes = &removed_nodes;
+        filter.removed_slots = &removed_slots;
+
+        int c = base_components.label[touched_node];
+        std::vector<int>& sizes = what_if_components.sizes;
+        for (const int* v = component_members.begin(c); v != component_members.end(c); ++v) {
+            int old_label = what_if_components.label[*v];
+            if (old_label >= 0 && --sizes[old_label] == 0) free_component_ids.push_back(old_label);
+            what_if_components.label[*v] = -1;
+        }
+        for (const int* v = component_members.begin(c); v != component_members.end(c); ++v) {
+            if (removed_nodes[*v] || what_if_components.label[*v] >= 0) continue;
+            int id;
+            if (free_component_ids.empty()) {
+                id = sizes.size();
+                sizes.push_back(0);
+            } else {
+                id = free_component_ids.back();
+                free_component_ids.pop_back();
             }
+            what_if_bfs.run(csr, *v, std::numeric_limits<int>::max(), filter);
+            for (int u : what_if_bfs.order()) what_if_components.label[u] = id;
+            sizes[id] = what_if_bfs.order().size();
+        }
+        what_if_component_count = sizes.size() - free_component_ids.size();
+        what_if_largest = sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end());
 
-            for (int i = 0; i < n; ++i) {
-                for (int neighbor_idx : adjacency_list[i]) {
-                    if (out_degree[i] > 0) {
-                        new_ranks[neighbor_idx] += damping_factor * (current_ranks[i] / out_degree[i]);
-                    }
-                }
+        what_if_rank = PageRankWarmStart(csr, what_if_rank, filter, 0.85f, 1e-5f, 100, &what_if_rank_iterations);
+        what_if_shifted.clear();
+        for (int i = 0; i < (int)nodes.size(); ++i) {
+            if (!removed_nodes[i] && what_if_rank[i] != base_rank[i]) what_if_shifted.push_back(i);
+        }
+        auto by_shift = [&](int a, int b) {
+            return std::fabs(what_if_rank[a] - base_rank[a]) > std::fabs(what_if_rank[b] - base_rank[b]);
+        };
+        int shown = std::min<int>(what_if_shifted.size(), 10);
+        std::partial_sort(what_if_shifted.begin(), what_if_shifted.begin() + shown, what_if_shifted.end(), by_shift);
+        what_if_shifted.resize(shown);
+        what_if_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void restoreWhatIf() {
+        what_if_active = false;
+        removed_nodes.clear();
+        removed_slots.clear();
+    }
+
+    bool hasNodeTypes() const {
+        for (const auto& node : nodes) {
+            if (!node.type.empty()) return true;
+        }
+        return false;
+    }
+
+    // Layer of every node for the layered and radial layouts: the type hierarchy when the data has types,
+    // dependency depth otherwise; empty when neither is known yet
+    std::vector<int> hierarchyLayers() const {
+        if (hasNodeTypes()) {
+            std::vector<std::string> types;
+            for (const auto& node : nodes) types.push_back(node.type);
+            return TypeLayers(types, springPairs());
+        }
+        if (analysis.dependency_depth.size() != nodes.size()) return {};
+        return analysis.dependency_depth;
+    }
+
+    // Places nodes in columns (or rings) by hierarchy layer, ordered within each to cut crossings
+    bool placeLayered(bool radial) {
+        std::vector<int> layers = hierarchyLayers();
+        if (layers.empty()) return false;
+        std::vector<std::vector<int>> rows = OrderLayers(csr, layers);
+        std::vector<ImVec2> positions = radial ? RadialPositions(rows, nodes.size()) : LayeredPositions(rows, nodes.size());
+        setNodePositions(positions);
+        return true;
+    }
+
+    // The layered result is final, so the spring simulation is paused
+    void applyLayeredLayout(bool radial = false) {
+        if (!placeLayered(radial)) return;
+        physics_enabled = false;
+        layout.setRunning(false);
+        postPositions();
+    }
+
+    bool isCyclicEdge(const Edge& edge) const {
+        return !analysis.scc.component.empty() && isDependencyEdge(edge) &&
+               analysis.scc.component[edge.from] == analysis.scc.component[edge.to] && analysis.scc.inCycle(edge.from);
+    }
+
+    // Restricts the canvas to the k-hop neighborhood of a node without touching the loaded graph
+    void focusOnNode(int node_index, int hops) {
+        focus = ego_extractor.extract(csr, node_index, hops);
+        in_focus.assign(nodes.size(), 0);
+        for (int v : focus.original_ids) in_focus[v] = 1;
+        focus_active = !focus.original_ids.empty();
+    }
+
+    void clearFocus() {
+        focus_active = false;
+        focus = Subgraph();
+    }
+
+    bool isVisible(int node_index) const {
+        return !focus_active || in_focus[node_index];
+    }
+
+    // Writes the triples among the focused nodes in the same format LoadTriplesFromCSV reads
+    bool exportFocusCSV(const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not write file " << filename << std::endl;
+            return false;
+        }
+        file << "node_name,edge_name,name_of_component,severity\n";
+        int written = 0;
+        for (int u : focus.original_ids) {
+            for (const int* e = outgoing_edges.begin(u); e != outgoing_edges.end(u); ++e) {
+                const Edge& edge = edges[*e];
+                if (!in_focus[edge.to]) continue;
+                file << nodes[edge.from].label << "," << edge.predicate << "," << nodes[edge.to].label << "," << edge.severity << "\n";
+                written++;
             }
-            current_ranks = new_ranks;
         }
-        
-        float sum = 0.0f;
-        for (const auto& pair : current_ranks) {
-            sum += pair.second;
+        std::cout << "Exported " << written << " triples to " << filename << std::endl;
+        return true;
+    }
+
+    // Writes per-node and per-triple analysis results to <prefix>_nodes.csv and <prefix>_edges.csv
+    bool exportAnalysisCSV(const std::string& prefix) {
+        std::ofstream node_file(prefix + "_nodes.csv");
+        std::ofstream edge_file(prefix + "_edges.csv");
+        if (!node_file.is_open() || !edge_file.is_open()) {
+            std::cerr << "Error: Could not write analysis files for " << prefix << std::endl;
+            return false;
         }
-        page_rank_average = sum / n;
-        
-        float variance_sum = 0.0f;
-        for (const auto& pair : current_ranks) {
-            variance_sum += pow(pair.second - page_rank_average, 2);
+        node_file << "node,connections,page_rank,clustering,articulation_point,scc,in_cycle,dependency_depth\n";
+        for (int i = 0; i < (int)nodes.size(); ++i) {
+            node_file << nodes[i].label << "," << nodes[i].connection_count << ",";
+            if (analysis.page_rank_scores.count(i)) node_file << analysis.page_rank_scores[i];
+            node_file << ",";
+            if (i < (int)analysis.clustering_coefficients.size()) node_file << analysis.clustering_coefficients[i];
+            node_file << ",";
+            if (i < (int)analysis.biconnectivity.is_articulation.size()) node_file << (analysis.biconnectivity.is_articulation[i] ? "yes" : "no");
+            node_file << ",";
+            if (i < (int)analysis.scc.component.size()) node_file << analysis.scc.component[i] << "," << (analysis.scc.inCycle(i) ? "yes" : "no");
+            else node_file << ",";
+            node_file << ",";
+            if (i < (int)analysis.dependency_depth.size()) node_file << analysis.dependency_depth[i];
+            node_file << "\n";
         }
-        page_rank_std_dev = sqrt(variance_sum / n);
-        
-        page_rank_scores = current_ranks;
+        edge_file << "node_name,edge_name,name_of_component,severity,bridge,in_cycle\n";
+        for (const auto& edge : edges) {
+            edge_file << nodes[edge.from].label << "," << edge.predicate << "," << nodes[edge.to].label << "," << edge.severity << ","
+                      << (analysis.biconnectivity.isBridge(edge.from, edge.to) ? "yes" : "no") << ","
+                      << (isCyclicEdge(edge) ? "yes" : "no") << "\n";
+        }
+        std::cout << "Exported analysis to " << prefix << "_nodes.csv and " << prefix << "_edges.csv" << std::endl;
+        return true;
+    }
+
+    // Per-node tables in the summary scroll inside a fixed height and submit only their visible rows
+    static constexpr ImGuiTableFlags kListTableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    static ImVec2 listTableSize() {
+        return ImVec2(0.0f, ImGui::GetTextLineHeightWithSpacing() * 12);
     }
 
     std::string getPageRankMeaning(float score) {
-        if (page_rank_std_dev == 0) {
+        if (analysis.page_rank_std_dev == 0) {
             return "Medium"; 
         }
     
-        if (score > page_rank_average + page_rank_std_dev) {
+        if (score > analysis.page_rank_average + analysis.page_rank_std_dev) {
             return "High";
         }
-        if (score < page_rank_average - page_rank_std_dev) {
+        if (score < analysis.page_rank_average - analysis.page_rank_std_dev) {
             return "Low";
         }
         return "Medium";
@@ -248,86 +4916,261 @@ public:
             return a.second > b.second;
         });
 
-        return predictions;
+        return predictions;
+    }
+
+    std::string getConceptualMeaning(float score) {
+        if (score >= 0.8f) return "Strong";
+        if (score >= 0.5f) return "Moderate";
+        if (score >= 0.0f) return "Weak";
+        return "";
+    }
+
+    std::vector<std::pair<int, int>> springPairs() const {
+        std::vector<std::pair<int, int>> springs;
+        for (const auto& edge : edges) springs.push_back({edge.from, edge.to});
+        return springs;
+    }
+
+    // Starts every node near its final place (pivot MDS scaled to the forces), so the simulation only has to polish
+    void placeInitialLayout() {
+        std::vector<ImVec2> positions = PivotMDS(csr, layout_rng, ImVec2(400.0f, 300.0f));
+        FitLayoutScale(springPairs(), layout_settings, positions);
+        setNodePositions(positions);
+    }
+
+    // Takes the positions of nodes known to the layout cache and places the rest next to their neighbors. A cache
+    // of the same graph reproduces the saved picture exactly; one with no label in common is ignored.
+    bool restoreCachedLayout() {
+        if (layout_cache_path.empty()) return false;
+        std::vector<std::string> labels;
+        for (const auto& node : nodes) labels.push_back(node.label);
+        std::vector<ImVec2> positions;
+        if (!RestoreLayout(layout_cache_path, labels, csr, graph_hash, layout_rng, positions)) return false;
+        setNodePositions(positions);
+        return true;
+    }
+
+    bool saveLayoutCache() {
+        if (layout_cache_path.empty() || nodes.empty()) return false;
+        std::vector<std::string> labels;
+        std::vector<ImVec2> positions;
+        for (const auto& node : nodes) {
+            labels.push_back(node.label);
+            positions.push_back(node.position);
+        }
+        return WriteLayoutCache(layout_cache_path, graph_hash, labels, positions);
+    }
+
+    // Hands the current edges and positions to a fresh layout thread, asleep until woken if `settled`
+    // With keep_center, gravity stays on layout_center instead of moving to the median of the new positions,
+    // so nodes placed around it (SettleLocally) do not drift off once the simulation resumes
+    void restartLayout(bool settled = false, bool keep_center = false) {
+        std::vector<std::pair<int, int>> springs = springPairs();
+        std::vector<ImVec2> positions;
+        for (const auto& node : nodes) positions.push_back(node.position);
+        if (!keep_center) layout_center = GravityCenter(positions, LayoutMasses(nodes.size(), springs));
+        layout_barrier = layout.restart(springs, positions, layout_settings, physics_enabled, settled);
+        if (keep_center) {
+            ImVec2 center = layout_center;
+            layout_barrier = layout.post([center](LayoutEngine& engine) { engine.setGravityCenter(center); });
+        }
+    }
+
+    // Hands the nodes and links appended from first_edge on and the new places of `moved` to the simulation,
+    // which carries on with everything else as it was
+    void extendLayout(int first_edge, const std::vector<int>& moved) {
+        std::vector<std::pair<int, int>> added;
+        for (int e = first_edge; e < (int)edges.size(); e++) added.push_back({edges[e].from, edges[e].to});
+        std::vector<std::pair<int, ImVec2>> places;
+        for (int v : moved) places.push_back({v, nodes[v].position});
+        int n = nodes.size();
+        layout_barrier = layout.post([n, added, places](LayoutEngine& engine) { engine.extend(n, added, places); });
+    }
+
+    // Lays the graph out level by level on the layout thread, then lets the simulation continue from there
+    void applyMultilevelLayout() {
+        layout.post([](LayoutEngine& engine) {
+            std::vector<ImVec2> positions;
+            engine.copyPositions(positions);
+            MultilevelLayout(engine.size(), engine.edgeList(), engine.settings, positions);
+            engine.setPositions(positions);
+        });
+    }
+
+    // Polishes the current layout by stress majorization on the layout thread, then holds it still: the
+    // spring forces would only pull it back toward their own equilibrium
+    void applyStressRefinement() {
+        std::shared_ptr<StressResult> result = stress_result;
+        layout.post([result](LayoutEngine& engine) {
+            std::vector<ImVec2> positions;
+            engine.copyPositions(positions);
+            StressReport report = RefineStress(BuildCSRFromEdges(engine.size(), engine.edgeList(), true), positions);
+            engine.setPositions(positions);
+            std::lock_guard<std::mutex> lock(result->mutex);
+            result->report = report;
+            result->done = true;
+        });
+        physics_enabled = false;
+        layout.setRunning(false);
+    }
+
+    // Sends positions set from the UI to the simulation, dropping momentum
+    void postPositions() {
+        std::vector<ImVec2> positions;
+        for (const auto& node : nodes) positions.push_back(node.position);
+        layout_center = GravityCenter(positions, LayoutMasses(nodes.size(), springPairs()));
+        layout_barrier = layout.post([positions](LayoutEngine& engine) { engine.setPositions(positions); });
     }
 
-    std::string getConceptualMeaning(float score) {
-        if (score >= 0.8f) return "Strong";
-        if (score >= 0.5f) return "Moderate";
-        if (score >= 0.0f) return "Weak";
-        return "";
+    void setNodePositions(const std::vector<ImVec2>& positions) {
+        for (int i = 0; i < (int)nodes.size(); i++) nodes[i].position = positions[i];
+        view_index_stale = true;
     }
 
-    void UpdatePhysics() {
-        float time_step = 0.5f;
-        float repulsion_strength = 2000.0f;
-        float attraction_strength = 0.02f;
-        float damping = 0.9f;
+    // Nothing on screen changes until the next input event: the layout sleeps and no background job is running
+    bool idle() {
+        return layout.idle() && !analysisPending() && !similarityPending();
+    }
 
-        for (int i = 0; i < nodes.size(); ++i) {
-            if (nodes[i].dragging) continue;
-            for (int j = i + 1; j < nodes.size(); ++j) {
-                if (nodes[j].dragging) continue;
-                ImVec2 delta = ImVec2(nodes[i].position.x - nodes[j].position.x, nodes[i].position.y - nodes[j].position.y);
-                float dist_sq = delta.x * delta.x + delta.y * delta.y;
-                if (dist_sq < 1.0f) dist_sq = 1.0f;
-                float force = repulsion_strength / dist_sq;
-                
-                float dist = sqrtf(dist_sq);
-                ImVec2 force_vector = ImVec2(delta.x / dist * force, delta.y / dist * force);
-                
-                velocities[i].x += force_vector.x;
-                velocities[i].y += force_vector.y;
-                velocities[j].x -= force_vector.x;
-                velocities[j].y -= force_vector.y;
-            }
+    // Copies the newest finished layout step into the nodes. A node being dragged follows the mouse instead.
+    void SyncLayout() {
+        const LayoutThread::Snapshot* snapshot = layout.latest();
+        if (!snapshot || snapshot->commands_applied < layout_barrier) return;
+        if (snapshot->positions.size() != nodes.size()) return;
+        if (snapshot->step_ms > 0.0) physics_step_ms = snapshot->step_ms;
+        physics_settled = snapshot->settled;
+        layout_center = snapshot->gravity_center;
+        for (int i = 0; i < (int)nodes.size(); ++i) {
+            if (!nodes[i].dragging) nodes[i].position = snapshot->positions[i];
         }
+        view_index_moved = true;
+    }
 
-        for (const auto& edge : edges) {
-            ImVec2 delta = ImVec2(nodes[edge.to].position.x - nodes[edge.from].position.x, nodes[edge.to].position.y - nodes[edge.from].position.y);
-            float dist = sqrtf(delta.x * delta.x + delta.y * delta.y);
-            if (dist < 1.0f) dist = 1.0f;
-            float force = (dist - 100.0f) * attraction_strength;
-            
-            ImVec2 force_vector = ImVec2(delta.x / dist * force, delta.y / dist * force);
-            
-            if (!nodes[edge.from].dragging) {
-                velocities[edge.from].x += force_vector.x;
-                velocities[edge.from].y += force_vector.y;
+    // Measures the labels added since the last frame and brings the viewport index up to date with the positions
+    void updateViewIndex() {
+        if (node_label_size.size() != nodes.size() || edge_label_size.size() != edges.size()) {
+            int measured_nodes = node_label_size.size(), measured_edges = edge_label_size.size();
+            if (measured_nodes == 0) node_label_extent = ImVec2(0.0f, 0.0f);
+            if (measured_edges == 0) edge_label_extent = ImVec2(0.0f, 0.0f);
+            node_label_size.resize(nodes.size());
+            edge_label_size.resize(edges.size());
+            for (int i = measured_nodes; i < (int)nodes.size(); i++) {
+                node_label_size[i] = ImGui::CalcTextSize(nodes[i].label.c_str());
+                node_label_extent.x = std::max(node_label_extent.x, node_label_size[i].x / 2.0f);
+                node_label_extent.y = std::max(node_label_extent.y, node_label_size[i].y / 2.0f);
             }
-            if (!nodes[edge.to].dragging) {
-                velocities[edge.to].x -= force_vector.x;
-                velocities[edge.to].y -= force_vector.y;
+            for (int e = measured_edges; e < (int)edges.size(); e++) {
+                edge_label_size[e] = ImGui::CalcTextSize(edges[e].predicate.c_str());
+                edge_label_extent.x = std::max(edge_label_extent.x, edge_label_size[e].x / 2.0f);
+                edge_label_extent.y = std::max(edge_label_extent.y, edge_label_size[e].y / 2.0f);
             }
         }
+        syncViewIndex();
+    }
 
-        for (int i = 0; i < nodes.size(); ++i) {
-            if (!nodes[i].dragging) {
-                nodes[i].position.x += velocities[i].x * time_step;
-                nodes[i].position.y += velocities[i].y * time_step;
-                velocities[i].x *= damping;
-                velocities[i].y *= damping;
-            }
+    // Brings the viewport index up to date with the positions
+    void syncViewIndex() {
+        if (view_index_stale) {
+            view_index.build(nodes, edges);
+        } else if (view_index_moved) {
+            view_index.update(nodes, edges);
         }
+        view_index_stale = view_index_moved = false;
     }
 
     void Render() {
         ImGui::Begin("Graph Visualizer", nullptr, ImGuiWindowFlags_MenuBar);
         if (ImGui::Button("Reset Layout")) {
-            int n = nodes.size();
-            for (int i = 0; i < n; i++) {
-                nodes[i].position = ImVec2(100.0f + (std::rand() % 600), 100.0f + (std::rand() % 400));
-                velocities[i] = ImVec2(0, 0);
-            }
+            // From the fixed seed, so every reset gives the layout the graph opened with
+            layout_rng = Pcg32(layout_seed);
+            placeInitialLayout();
             selected_node = -1;
             pan_offset = ImVec2(0.0f, 0.0f);
+            postPositions();
+            physics_enabled = true;
+            layout.setRunning(true);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Layered Layout")) {
+            applyLayeredLayout();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Radial Layout")) {
+            applyLayeredLayout(true);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Multilevel Layout")) {
+            applyMultilevelLayout();
+            physics_enabled = true;
+            layout.setRunning(true);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Stress Refine")) {
+            applyStressRefinement();
+        }
+        {
+            std::lock_guard<std::mutex> lock(stress_result->mutex);
+            const StressReport& report = stress_result->report;
+            if (stress_result->done && report.initial_stress > 0.0) {
+                ImGui::SameLine();
+                ImGui::Text("stress -%.1f%%, %d it, %.2f ms/it", 100.0 * (1.0 - report.final_stress / report.initial_stress),
+                            report.iterations, report.ms_per_iteration);
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save Layout")) {
+            saveLayoutCache();
+        }
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Physics", &physics_enabled)) {
+            layout.setRunning(physics_enabled);
+        }
+        ImGui::SameLine();
+        const char* repulsion_modes[] = {"Exact", "Barnes-Hut", "Grid"};
+        ImGui::SetNextItemWidth(110.0f);
+        bool settings_changed = ImGui::Combo("Repulsion", &layout_settings.repulsion_mode, repulsion_modes, 3);
+        if (layout_settings.repulsion_mode == LayoutEngine::REPULSION_BARNES_HUT) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(80.0f);
+            settings_changed |= ImGui::SliderFloat("Theta", &layout_settings.barnes_hut_theta, 0.2f, 1.5f, "%.2f");
+        } else if (layout_settings.repulsion_mode == LayoutEngine::REPULSION_GRID) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(80.0f);
+            settings_changed |= ImGui::SliderFloat("Cutoff", &layout_settings.grid_cutoff, 100.0f, 1000.0f, "%.0f");
+        }
+        ImGui::SameLine();
+        settings_changed |= ImGui::Checkbox("Adaptive", &layout_settings.adaptive_speed);
+        if (settings_changed) {
+            LayoutEngine::Settings settings = layout_settings;
+            layout.post([settings](LayoutEngine& engine) { engine.settings = settings; });
         }
         ImGui::SameLine();
+        if (physics_enabled && physics_settled) ImGui::Text("%.2f ms/step, settled", physics_step_ms);
+        else ImGui::Text("%.2f ms/step", physics_step_ms);
+        ImGui::SameLine();
         if (ImGui::Button("Clear Selection")) {
             selected_node = -1;
             for (auto& n : nodes) n.selected = false;
         }
         ImGui::SameLine();
+        ImGui::SetNextItemWidth(80.0f);
+        ImGui::SliderInt("Hops", &focus_hops, 1, 5);
+        ImGui::SameLine();
+        if (ImGui::Button("Focus Neighborhood") && selected_node >= 0) {
+            focusOnNode(selected_node, focus_hops);
+        }
+        if (focus_active) {
+            ImGui::SameLine();
+            if (ImGui::Button("Export Focus")) {
+                exportFocusCSV("ego_" + nodes[focus.original_ids[0]].label + "_" + std::to_string(focus_hops) + "hop.csv");
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Show All")) {
+                clearFocus();
+            }
+        }
+        ImGui::SameLine();
         ImGui::TextDisabled("(Pan: left-drag on empty space / right-drag / two-finger trackpad)");
         ImGui::Separator();
         ImVec2 canvas_pos = ImGui::GetCursorScreenPos();
@@ -355,9 +5198,17 @@ public:
             pan_offset.x += io.MouseWheelH * 30.0f;
             pan_offset.y += io.MouseWheel * 30.0f;
         }
+        updateViewIndex();
+        // The canvas in world coordinates; only what overlaps it is drawn
+        ImVec2 view_lo = screen_to_world(ImGui::GetCursorScreenPos());
+        ImVec2 view_hi = ImVec2(view_lo.x + main_canvas_size.x, view_lo.y + main_canvas_size.y);
         int hover_node = -1;
         bool mouse_in_canvas = (mouse_pos.x >= ImGui::GetCursorScreenPos().x && mouse_pos.x <= ImGui::GetCursorScreenPos().x + main_canvas_size.x && mouse_pos.y >= ImGui::GetCursorScreenPos().y && mouse_pos.y <= ImGui::GetCursorScreenPos().y + main_canvas_size.y);
-        for (int i = 0; i < (int)nodes.size(); ++i) {
+        ImVec2 mouse_world = screen_to_world(mouse_pos);
+        view_index.queryNodes(ImVec2(mouse_world.x - kMaxNodeRadius, mouse_world.y - kMaxNodeRadius),
+                              ImVec2(mouse_world.x + kMaxNodeRadius, mouse_world.y + kMaxNodeRadius), candidate_nodes);
+        for (int i : candidate_nodes) {
+            if (!isVisible(i)) continue;
             ImVec2 node_screen_pos = world_to_screen(nodes[i].position);
             float dist_to_mouse = sqrtf(pow(mouse_pos.x - node_screen_pos.x, 2) + pow(mouse_pos.y - node_screen_pos.y, 2));
             if (dist_to_mouse < nodes[i].radius) {
@@ -385,33 +5236,65 @@ public:
         if (is_panning && !ImGui::IsMouseDown(0) && !ImGui::IsMouseDown(1)) {
             is_panning = false;
         }
-        for (const auto& edge : edges) {
-            ImVec2 p1 = world_to_screen(nodes[edge.from].position);
-            ImVec2 p2 = world_to_screen(nodes[edge.to].position);
+        // Thick lines reach a little past the view; a label can stick into it from a link that stays outside
+        const float line_margin = 2.0f;
+        view_index.queryEdges(ImVec2(view_lo.x - edge_label_extent.x - line_margin, view_lo.y - edge_label_extent.y - line_margin),
+                              ImVec2(view_hi.x + edge_label_extent.x + line_margin, view_hi.y + edge_label_extent.y + line_margin),
+                              candidate_edges);
+        drawn_edges = 0;
+        for (int e : candidate_edges) {
+            const Edge& edge = edges[e];
+            if (!isVisible(edge.from) || !isVisible(edge.to)) continue;
+            ImVec2 from = nodes[edge.from].position, to = nodes[edge.to].position;
+            ImVec2 mid_world = ImVec2((from.x + to.x) / 2.0f, (from.y + to.y) / 2.0f);
+            ImVec2 half_label = ImVec2(edge_label_size[e].x / 2.0f, edge_label_size[e].y / 2.0f);
+            bool line_on_screen = SegmentIntersectsBox(from, to, ImVec2(view_lo.x - line_margin, view_lo.y - line_margin),
+                                                       ImVec2(view_hi.x + line_margin, view_hi.y + line_margin));
+            bool label_on_screen = BoxesOverlap(ImVec2(mid_world.x - half_label.x, mid_world.y - half_label.y),
+                                                ImVec2(mid_world.x + half_label.x, mid_world.y + half_label.y), view_lo, view_hi);
+            if (!line_on_screen && !label_on_screen) continue;
+            drawn_edges++;
+            ImVec2 p1 = world_to_screen(from);
+            ImVec2 p2 = world_to_screen(to);
             ImU32 color = IM_COL32(0, 0, 0, 255);
             float draw_thickness = 1.5f;
-            draw_list->AddLine(p1, p2, color, draw_thickness);
-            ImVec2 mid_point = ImVec2((p1.x + p2.x) / 2.0f, (p1.y + p2.y) / 2.0f);
-            ImVec2 text_size = ImGui::CalcTextSize(edge.predicate.c_str());
-            ImVec2 text_pos = ImVec2(mid_point.x - text_size.x / 2.0f, mid_point.y - text_size.y / 2.0f);
-            draw_list->AddText(text_pos, IM_COL32(0, 0, 0, 255), edge.predicate.c_str());
-        }
-
-        int max_connections = 0;
-        if (!nodes.empty()) {
-            for (const auto& node : nodes) {
-                if (node.connection_count > max_connections) {
-                    max_connections = node.connection_count;
-                }
+            if (isLinkRemoved(edge.from, edge.to)) {
+                color = IM_COL32(200, 200, 200, 255); // Grey: removed in the what-if view
+                draw_thickness = 1.0f;
+            } else if (analysis.biconnectivity.isBridge(edge.from, edge.to)) {
+                color = IM_COL32(200, 0, 200, 255); // Magenta: single point of failure
+                draw_thickness = 4.0f;
+            } else if (isCyclicEdge(edge)) {
+                color = IM_COL32(230, 120, 0, 255); // Orange: part of a dependency cycle
+                draw_thickness = 3.0f;
+            }
+            if (line_on_screen) draw_list->AddLine(p1, p2, color, draw_thickness);
+            if (label_on_screen) {
+                ImVec2 mid_point = world_to_screen(mid_world);
+                ImVec2 text_pos = ImVec2(mid_point.x - half_label.x, mid_point.y - half_label.y);
+                draw_list->AddText(text_pos, IM_COL32(0, 0, 0, 255), edge.predicate.c_str());
             }
         }
 
-        for (int i = 0; i < (int)nodes.size(); ++i) {
+        // Rings reach 10 px past the largest node; a dragged node keeps getting its events wherever it is
+        const float ring_margin = 10.0f;
+        float node_margin_x = std::max(kMaxNodeRadius + ring_margin, node_label_extent.x);
+        float node_margin_y = std::max(kMaxNodeRadius + ring_margin, node_label_extent.y);
+        view_index.queryNodes(ImVec2(view_lo.x - node_margin_x, view_lo.y - node_margin_y),
+                              ImVec2(view_hi.x + node_margin_x, view_hi.y + node_margin_y), candidate_nodes);
+        if (selected_node >= 0 && selected_node < (int)nodes.size() && nodes[selected_node].dragging &&
+            !std::binary_search(candidate_nodes.begin(), candidate_nodes.end(), selected_node)) {
+            candidate_nodes.insert(std::lower_bound(candidate_nodes.begin(), candidate_nodes.end(), selected_node), selected_node);
+        }
+        drawn_nodes = 0;
+        for (int i : candidate_nodes) {
+            if (!isVisible(i)) continue;
             ImVec2 node_screen_pos = world_to_screen(nodes[i].position);
             float dist_to_mouse = sqrtf(pow(mouse_pos.x - node_screen_pos.x, 2) + pow(mouse_pos.y - node_screen_pos.y, 2));
             bool mouse_over_node = dist_to_mouse < nodes[i].radius;
             if (mouse_left_clicked && mouse_over_node && !nodes[i].dragging) {
                 nodes[i].dragging = true;
+                layout.post([i](LayoutEngine& engine) { engine.setPinned(i, true); });
                 nodes[i].drag_offset = ImVec2(mouse_pos.x - node_screen_pos.x, mouse_pos.y - node_screen_pos.y);
                 selected_node = i;
                 for (auto& n : nodes) n.selected = false;
@@ -422,11 +5305,27 @@ public:
                 if (mouse_dragging_left) {
                     ImVec2 raw_world = screen_to_world(ImVec2(mouse_pos.x, mouse_pos.y));
                     nodes[i].position = ImVec2(raw_world.x - nodes[i].drag_offset.x, raw_world.y - nodes[i].drag_offset.y);
+                    view_index_moved = true;
+                    ImVec2 position = nodes[i].position;
+                    layout.post([i, position](LayoutEngine& engine) { engine.setPosition(i, position); });
                 }
                 else if (mouse_released) {
                     nodes[i].dragging = false;
+                    ImVec2 position = nodes[i].position;
+                    layout_barrier = layout.post([i, position](LayoutEngine& engine) {
+                        engine.setPosition(i, position);
+                        engine.setPinned(i, false);
+                    });
                 }
             }
+            ImVec2 position = nodes[i].position;
+            float reach = nodes[i].radius + ring_margin;
+            ImVec2 half_label = ImVec2(node_label_size[i].x / 2.0f, node_label_size[i].y / 2.0f);
+            bool on_screen = BoxesOverlap(ImVec2(position.x - reach, position.y - reach), ImVec2(position.x + reach, position.y + reach), view_lo, view_hi) ||
+                             BoxesOverlap(ImVec2(position.x - half_label.x, position.y - half_label.y),
+                                          ImVec2(position.x + half_label.x, position.y + half_label.y), view_lo, view_hi);
+            if (!on_screen) continue;
+            drawn_nodes++;
             float normalized_connections = max_connections > 0 ? static_cast<float>(nodes[i].connection_count) / max_connections : 0.0f;
 
             ImU32 node_color;
@@ -450,17 +5349,21 @@ public:
                     }
             }
 
-            float min_radius = 15.0f;
-            float max_radius = 40.0f;
-            nodes[i].radius = min_radius + (max_radius - min_radius) * normalized_connections;
-            if (nodes[i].radius < min_radius) nodes[i].radius = min_radius;
+            if (isRemoved(i)) {
+                node_color = IM_COL32(210, 210, 210, 255);
+            }
 
             draw_list->AddCircleFilled(node_screen_pos, nodes[i].radius, node_color);
-            draw_list->AddCircle(node_screen_pos, nodes[i].radius, IM_COL32(0, 0, 0, 255), 0, 2.0f);
-            std::string label = nodes[i].label;
-            ImVec2 text_size = ImGui::CalcTextSize(label.c_str());
-            ImVec2 text_pos = ImVec2(node_screen_pos.x - text_size.x / 2.0f, node_screen_pos.y - text_size.y / 2.0f);
-            draw_list->AddText(text_pos, IM_COL32(0, 0, 0, 255), label.c_str());
+            if (highlight_impact && i < (int)in_impact.size() && in_impact[i]) {
+                draw_list->AddCircle(node_screen_pos, nodes[i].radius + 8.0f, IM_COL32(220, 40, 40, 255), 0, 3.0f);
+            }
+            if (i < (int)analysis.biconnectivity.is_articulation.size() && analysis.biconnectivity.is_articulation[i]) {
+                draw_list->AddCircle(node_screen_pos, nodes[i].radius + 3.0f, IM_COL32(200, 0, 200, 255), 0, 4.0f);
+            } else {
+                draw_list->AddCircle(node_screen_pos, nodes[i].radius, IM_COL32(0, 0, 0, 255), 0, 2.0f);
+            }
+            ImVec2 text_pos = ImVec2(node_screen_pos.x - half_label.x, node_screen_pos.y - half_label.y);
+            draw_list->AddText(text_pos, IM_COL32(0, 0, 0, 255), nodes[i].label.c_str());
         }
         ImGui::SetCursorPos(ImVec2(10, ImGui::GetWindowHeight() - 120));
         ImGui::BeginChild("InfoPanel", ImVec2(320, 110), true);
@@ -485,6 +5388,7 @@ public:
         } else ImGui::Text("No node selected (left-click to select / drag).");
         ImGui::Separator();
         ImGui::Text("Pan offset: (%.1f, %.1f) (left-drag empty / right-drag / two-finger trackpad)", pan_offset.x, pan_offset.y);
+        ImGui::Text("Drawn: %d of %d nodes, %d of %d links", drawn_nodes, (int)nodes.size(), drawn_edges, (int)edges.size());
         ImGui::EndChild();
         ImGui::EndChild();
 
@@ -505,6 +5409,11 @@ public:
         ImGui::Text("------------------");
         ImGui::Text("Number of Nodes: %lu", nodes.size());
         ImGui::Text("Number of Edges: %lu", edges.size());
+        if (analysisPending()) ImGui::TextDisabled("Analyzing...");
+        ImGui::Text("------------------");
+        if (ImGui::Button("Export Analysis")) {
+            exportAnalysisCSV("graph_analysis");
+        }
         ImGui::Text("------------------");
 
         if (selected_node >= 0 && selected_node < nodes.size()) {
@@ -561,36 +5470,352 @@ public:
         ImGui::PopStyleVar();
         ImGui::Separator();
         
-        if (page_rank_scores.empty()) {
+        if (analysis.page_rank_scores.empty()) {
             ImGui::Text("No data to calculate Page Rank.");
         } else {
-            if (ImGui::BeginTable("pagerank_table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+            if (ImGui::BeginTable("pagerank_table", 3, kListTableFlags, listTableSize())) {
+                ImGui::TableSetupScrollFreeze(0, 1);
                 ImGui::TableSetupColumn("Node");
                 ImGui::TableSetupColumn("Score");
                 ImGui::TableSetupColumn("Connectivity");
                 ImGui::TableHeadersRow();
 
-                for (const auto& rank_pair : page_rank_scores) {
+                // Only the rows in view are submitted
+                ImGuiListClipper clipper;
+                clipper.Begin((int)analysis.page_rank_order.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                        int i = analysis.page_rank_order[row];
+                        float score = analysis.page_rank_scores.at(i);
+                        ImGui::TableNextRow();
+
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(nodes[i].label.c_str());
+
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.5f", score);
+
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(getPageRankMeaning(score).c_str());
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Clustering Coefficient");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (analysis.clustering_coefficients.empty()) {
+            ImGui::Text("No data to calculate clustering.");
+        } else {
+            ImGui::Text("Triangles: %.0f%s", analysis.triangle_stats.total, analysis.triangle_stats.sampled ? " (estimated)" : "");
+            ImGui::Text("Average coefficient: %.3f", analysis.average_clustering);
+            if (ImGui::BeginTable("clustering_table", 3, kListTableFlags, listTableSize())) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Node");
+                ImGui::TableSetupColumn("Triangles");
+                ImGui::TableSetupColumn("Coefficient");
+                ImGui::TableHeadersRow();
+
+                ImGuiListClipper clipper;
+                clipper.Begin((int)analysis.clustering_order.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                        int i = analysis.clustering_order[row];
+                        ImGui::TableNextRow();
+
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(nodes[i].label.c_str());
+
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.0f", analysis.triangle_stats.per_node[i]);
+
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", analysis.clustering_coefficients[i]);
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Single Points of Failure");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (analysis.biconnectivity.is_articulation.empty()) {
+            ImGui::Text("No data to analyze connectivity.");
+        } else {
+            int articulation_count = std::count(analysis.biconnectivity.is_articulation.begin(), analysis.biconnectivity.is_articulation.end(), 1);
+            ImGui::Text("Articulation points: %d", articulation_count);
+            ImGui::Text("Bridges: %lu", analysis.biconnectivity.bridges.size());
+            ImGui::Text("Biconnected components: %d", analysis.biconnectivity.component_count);
+            if (ImGui::BeginTable("failure_table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+                ImGui::TableSetupColumn("Element");
+                ImGui::TableSetupColumn("Kind");
+                ImGui::TableHeadersRow();
+
+                for (int i = 0; i < (int)nodes.size(); ++i) {
+                    if (!analysis.biconnectivity.is_articulation[i]) continue;
                     ImGui::TableNextRow();
-                    
                     ImGui::TableNextColumn();
-                    ImGui::TextUnformatted(nodes[rank_pair.first].label.c_str());
-                    
+                    ImGui::TextUnformatted(nodes[i].label.c_str());
                     ImGui::TableNextColumn();
-                    ImGui::Text("%.5f", rank_pair.second);
-                    
+                    ImGui::TextUnformatted("Node");
+                }
+                for (const auto& bridge : analysis.biconnectivity.bridges) {
+                    ImGui::TableNextRow();
                     ImGui::TableNextColumn();
-                    ImGui::TextUnformatted(getPageRankMeaning(rank_pair.second).c_str());
+                    ImGui::Text("%s - %s", nodes[bridge.first].label.c_str(), nodes[bridge.second].label.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted("Link");
                 }
                 ImGui::EndTable();
             }
         }
-        
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Cyclic Dependencies");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        std::vector<const char*> relation_names = {"All relations"};
+        for (const auto& predicate : predicates) relation_names.push_back(predicate.c_str());
+        if (ImGui::Combo("Relation", &dependency_predicate, relation_names.data(), (int)relation_names.size())) {
+            buildDependencyGraph();
+            analysis.clearDependencies();
+            cycle_listing.clear();
+            startAnalysis(true);
+        }
+        if (analysis.scc.component.empty()) {
+            ImGui::Text("No data to detect cycles.");
+        } else {
+            ImGui::Text("Strongly connected components: %d", analysis.scc.count());
+            ImGui::Text("Cycles: %d", (int)cycle_listing.size());
+            for (const auto& text : cycle_listing) ImGui::TextWrapped("%s", text.c_str());
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Dependency Depth");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (analysis.dependency_depth.empty()) {
+            ImGui::Text("No data to order dependencies.");
+        } else {
+            ImGui::Text("Critical path: %d steps", analysis.dependency_levels.critical_path);
+            if (ImGui::BeginTable("depth_table", 2, kListTableFlags, listTableSize())) {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableSetupColumn("Node");
+                ImGui::TableSetupColumn("Depth");
+                ImGui::TableHeadersRow();
+
+                ImGuiListClipper clipper;
+                clipper.Begin((int)analysis.depth_order.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                        int i = analysis.depth_order[row];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(nodes[i].label.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", analysis.dependency_depth[i]);
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Failure Impact");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (selected_node < 0 || analysis.scc.component.empty()) {
+            ImGui::Text("Select a node to see what it affects.");
+        } else {
+            if (selected_node != impact_source) updateImpact(selected_node);
+            ImGui::Checkbox("Highlight affected", &highlight_impact);
+            ImGui::Text("'%s' affects %lu nodes (%.1f us, %s)", nodes[selected_node].label.c_str(), impact_nodes.size(),
+                        impact_query_us, analysis.reachability.usesClosure() ? "closure" : "interval labels");
+            if (!impact_nodes.empty()) {
+                // A hub can affect most of the graph, so the list scrolls and only its visible lines are submitted
+                float list_height = std::min(listTableSize().y, ImGui::GetTextLineHeightWithSpacing() * (impact_nodes.size() + 1));
+                ImGui::BeginChild("impact_list", ImVec2(0.0f, list_height), true);
+                ImGuiListClipper clipper;
+                clipper.Begin((int)impact_nodes.size());
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                        ImGui::BulletText("%s", nodes[impact_nodes[row]].label.c_str());
+                    }
+                }
+                ImGui::EndChild();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("What-If Removal");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (selected_node >= 0 && selected_node < (int)nodes.size()) {
+            if (!isRemoved(selected_node) && ImGui::Button("Remove selected node")) {
+                removeNodeWhatIf(selected_node);
+            }
+            for (const int* v = csr.begin(selected_node); v != csr.end(selected_node); ++v) {
+                if (isLinkRemoved(selected_node, *v)) continue;
+                ImGui::PushID(*v);
+                if (ImGui::SmallButton("Remove link")) removeLinkWhatIf(selected_node, *v);
+                ImGui::SameLine();
+                ImGui::Text("to %s", nodes[*v].label.c_str());
+                ImGui::PopID();
+            }
+        } else {
+            ImGui::Text("Select a node to remove it or its links.");
+        }
+        if (what_if_active) {
+            if (ImGui::Button("Restore All")) {
+                restoreWhatIf();
+            }
+        }
+        if (what_if_active) {
+            ImGui::Text("Components: %d -> %d", base_component_count, what_if_component_count);
+            ImGui::Text("Largest component: %d -> %d nodes", base_largest, what_if_largest);
+            ImGui::Text("Updated in %.2f ms (%d PageRank iterations)", what_if_ms, what_if_rank_iterations);
+
+            if (!what_if_shifted.empty() && ImGui::BeginTable("what_if_table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+                ImGui::TableSetupColumn("Node");
+                ImGui::TableSetupColumn("Page Rank");
+                ImGui::TableSetupColumn("Shift");
+                ImGui::TableHeadersRow();
+
+                for (int v : what_if_shifted) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(nodes[v].label.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.5f", what_if_rank[v]);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%+.5f", what_if_rank[v] - base_rank[v]);
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Maximal Cliques");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        ImGui::SliderInt("Min size", &clique_min_size, 3, 10);
+        ImGui::SliderFloat("Budget (ms)", &clique_budget_ms, 10.0f, 5000.0f, "%.0f");
+        if (ImGui::Button("Find Cliques")) {
+            calculateCliques();
+        }
+        if (!cliques_complete) {
+            ImGui::Text("Time budget reached; results are partial.");
+        }
+        if (!cliques.empty()) {
+            ImGui::Text("Cliques found: %lu", cliques.size());
+            if (ImGui::BeginTable("clique_table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+                ImGui::TableSetupColumn("Members");
+                ImGui::TableSetupColumn("Size");
+                ImGui::TableSetupColumn("Systemic");
+                ImGui::TableHeadersRow();
+
+                for (size_t c = 0; c < cliques.size(); ++c) {
+                    std::string members;
+                    for (int v : cliques[c]) members += (members.empty() ? "" : ", ") + nodes[v].label;
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextWrapped("%s", members.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%lu", cliques[c].size());
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(clique_systemic[c] ? "Yes" : "No");
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 5));
+        ImGui::Text("Similar Nodes (SimRank)");
+        ImGui::PopStyleVar();
+        ImGui::Separator();
+
+        if (selected_node < 0 || selected_node >= (int)nodes.size()) {
+            ImGui::Text("Select a node to find structurally similar ones.");
+        } else {
+            if (selected_node != simrank_source) updateSimilarNodes(selected_node);
+            if (similarityPending()) {
+                ImGui::TextDisabled("Computing...");
+            } else if (similar_nodes.empty()) {
+                ImGui::Text("No similar nodes found.");
+            } else if (ImGui::BeginTable("simrank_table", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+                ImGui::TableSetupColumn("Node");
+                ImGui::TableSetupColumn("Similarity");
+                ImGui::TableHeadersRow();
+
+                for (const auto& similar : similar_nodes) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(nodes[similar.first].label.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", similar.second);
+                }
+                ImGui::EndTable();
+            }
+        }
+
         ImGui::EndChild();
         ImGui::End();
     }
 };
+#endif // GRAPH_HEADLESS
+
+// Splits one CSV record, honoring double-quoted fields with "" for a literal quote
+std::vector<std::string> SplitCSVLine(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') fields.back() += line[++i];
+            else if (c == '"') quoted = false;
+            else fields.back() += c;
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
 
+// Reads triples from a CSV whose columns are found by header name: node_name or subj_text, edge_name or
+// predicate, name_of_component or obj_text, severity, and optionally subj_type and obj_type. A header that
+// names none of them means the classic four columns in order.
 std::vector<Triple> LoadTriplesFromCSV(const std::string& filename) {
     std::vector<Triple> triples;
     std::ifstream file(filename);
@@ -602,21 +5827,37 @@ std::vector<Triple> LoadTriplesFromCSV(const std::string& filename) {
 
     std::string line;
     std::getline(file, line);
-
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string node_name, edge_name, name_of_component, severity;
-
-        if (std::getline(ss, node_name, ',') &&
-            std::getline(ss, edge_name, ',') &&
-            std::getline(ss, name_of_component, ',') &&
-            std::getline(ss, severity))
-        {
-            if (!severity.empty() && severity.back() == '\r') {
-                severity.pop_back();
+    std::vector<std::string> header = SplitCSVLine(line);
+    auto column = [&header](std::initializer_list<const char*> names) {
+        for (size_t i = 0; i < header.size(); ++i) {
+            for (const char* name : names) {
+                if (header[i] == name) return (int)i;
             }
-            triples.push_back({node_name, edge_name, name_of_component, severity});
         }
+        return -1;
+    };
+    int subject = column({"node_name", "subj_text"}), predicate = column({"edge_name", "predicate"});
+    int object = column({"name_of_component", "obj_text"}), severity = column({"severity"});
+    int subject_type = column({"subj_type"}), object_type = column({"obj_type"});
+    if (subject < 0 && object < 0) {
+        subject = 0;
+        predicate = 1;
+        object = 2;
+        severity = 3;
+    }
+    if (subject < 0 || object < 0) {
+        std::cerr << "Error: " << filename << " has no subject or object column" << std::endl;
+        return triples;
+    }
+    auto field = [](const std::vector<std::string>& fields, int index) {
+        return index >= 0 && index < (int)fields.size() ? fields[index] : std::string();
+    };
+
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = SplitCSVLine(line);
+        if ((int)fields.size() <= std::max(subject, object)) continue;
+        triples.push_back({fields[subject], field(fields, predicate), fields[object], field(fields, severity),
+                           field(fields, subject_type), field(fields, object_type)});
     }
 
     file.close();
@@ -624,7 +5865,121 @@ std::vector<Triple> LoadTriplesFromCSV(const std::string& filename) {
     return triples;
 }
 
-int main() {
+// Runs the force layout of a CSV for a fixed number of steps from the same seeded start as the app and
+// prints the time per step and a checksum of the final positions. The checksum only depends on the input,
+// the seed and the steps, so it catches behavior changes while the timing tracks performance.
+int RunLayoutBenchmark(const std::string& filename, int steps, uint64_t seed) {
+    std::vector<Triple> triples = LoadTriplesFromCSV(filename);
+    std::vector<std::string> labels;
+    std::map<std::string, int> node_map = IndexTripleNodes(triples, labels);
+    std::vector<std::pair<int, int>> springs = TripleLinks(triples, node_map);
+    Pcg32 rng(seed);
+    std::vector<ImVec2> positions = PivotMDS(BuildCSRFromEdges(labels.size(), springs, true), rng, ImVec2(400.0f, 300.0f));
+
+    LayoutEngine engine;
+    FitLayoutScale(springs, engine.settings, positions);
+    engine.reset(springs, positions);
+    auto start = std::chrono::steady_clock::now();
+    int settled_at = -1; // steps until the layout first counted as settled, as the app would stop there
+    for (int s = 0; s < steps; ++s) {
+        engine.step();
+        if (settled_at < 0 && engine.settled()) settled_at = s + 1;
+    }
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    engine.copyPositions(positions);
+
+    uint64_t checksum = 14695981039346656037ULL; // FNV-1a over the position bits
+    for (const auto& p : positions) {
+        for (float f : {p.x, p.y}) {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            checksum = (checksum ^ bits) * 1099511628211ULL;
+        }
+    }
+    std::cout << labels.size() << " nodes, " << springs.size() << " links, " << steps << " steps on " << WorkerCount()
+              << " threads: " << total_ms / std::max(steps, 1) << " ms per step, checksum " << std::hex << checksum
+              << std::dec << std::endl;
+    if (settled_at >= 0) std::cout << "Settled after " << settled_at << " steps" << std::endl;
+    else std::cout << "Not settled after " << steps << " steps" << std::endl;
+    return 0;
+}
+
+// Lays out a CSV without opening a window, on all cores, until the layout settles or `max_steps` pass, and
+// writes the positions to `output`: JSON when it ends in ".json", otherwise the layout cache format, which the
+// app picks up on its next start when written to "<csv>.layout". An existing cache at `output` is the
+// starting point, so nightly runs over growing data only move what changed. A positive `stress_iterations`
+// adds up to that many rounds of stress majorization after the force layout.
+int RunHeadlessLayout(const std::string& filename, int max_steps, const std::string& output, int stress_iterations) {
+    std::vector<Triple> triples = LoadTriplesFromCSV(filename);
+    if (triples.empty()) return 1;
+    std::vector<std::string> labels;
+    std::map<std::string, int> node_map = IndexTripleNodes(triples, labels);
+    std::vector<std::pair<int, int>> springs = TripleLinks(triples, node_map);
+    CSRGraph g = BuildCSRFromEdges(labels.size(), springs, true);
+    uint64_t graph_hash = GraphContentHash(labels, springs);
+    bool json = output.size() >= 5 && output.compare(output.size() - 5, 5, ".json") == 0;
+
+    auto start = std::chrono::steady_clock::now();
+    LayoutEngine engine;
+    if (labels.size() > 2000) engine.settings.repulsion_mode = LayoutEngine::REPULSION_BARNES_HUT;
+    Pcg32 rng(1);
+    std::vector<ImVec2> positions;
+    if (json || !RestoreLayout(output, labels, g, graph_hash, rng, positions)) {
+        positions = PivotMDS(g, rng, ImVec2(400.0f, 300.0f));
+        FitLayoutScale(springs, engine.settings, positions);
+    }
+    engine.reset(springs, positions);
+    int steps = 0;
+    while (steps < max_steps && !engine.settled()) {
+        engine.step();
+        steps++;
+    }
+    engine.copyPositions(positions);
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << labels.size() << " nodes, " << springs.size() << " links: " << steps << " steps on " << WorkerCount()
+              << " threads in " << total_ms << " ms, " << (engine.settled() ? "settled" : "not settled")
+              << " (mean displacement " << engine.meanDisplacement() << ")" << std::endl;
+    if (stress_iterations > 0) {
+        StressReport report = RefineStress(g, positions, stress_iterations);
+        std::cout << "Stress majorization: " << report.terms << " terms set up in " << report.setup_ms << " ms, "
+                  << report.iterations << " iterations at " << report.ms_per_iteration << " ms, stress "
+                  << report.initial_stress << " -> " << report.final_stress << std::endl;
+    }
+
+    bool written = json ? WriteLayoutJSON(output, labels, positions)
+                        : WriteLayoutCache(output, graph_hash, labels, positions);
+    if (!written) return 1;
+    std::cout << "Wrote positions to " << output << std::endl;
+    return 0;
+}
+
+// Usage:
+//   main                                  opens graph_data.csv in the viewer
+//   main --bench-bfs [scale=20] [edge_factor=16]
+//   main --bench-layout <csv> [steps=500] [seed=1]
+//   main --headless <csv> [max_steps=5000] [output=<csv>.layout] [stress_iterations=0]
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench-bfs") {
+        int scale = argc > 2 ? std::atoi(argv[2]) : 20;
+        int edge_factor = argc > 3 ? std::atoi(argv[3]) : 16;
+        return RunBFSBenchmark(scale, edge_factor);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--bench-layout") {
+        int steps = argc > 3 ? std::atoi(argv[3]) : 500;
+        uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+        return RunLayoutBenchmark(argv[2], steps, seed);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--headless") {
+        int max_steps = argc > 3 ? std::atoi(argv[3]) : 5000;
+        std::string output = argc > 4 ? argv[4] : std::string(argv[2]) + ".layout";
+        int stress_iterations = argc > 5 ? std::atoi(argv[5]) : 0;
+        return RunHeadlessLayout(argv[2], max_steps, output, stress_iterations);
+    }
+
+#ifdef GRAPH_HEADLESS
+    std::cerr << "Usage: " << argv[0] << " --headless <csv> [max_steps] [output] [stress_iterations]" << std::endl;
+    return 1;
+#else
     if (!glfwInit()) return -1;
     GLFWwindow* window = glfwCreateWindow(1200, 800, "Semantic Graph Visualizer", NULL, NULL);
     if (!window) {
@@ -632,6 +5987,7 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(1);
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
@@ -651,21 +6007,46 @@ int main() {
     graph.setLargeFont(large_font);
 
     std::string filename = "graph_data.csv";
+    graph.setLayoutCachePath(filename + ".layout");
     std::vector<Triple> triples_from_file = LoadTriplesFromCSV(filename);
 
     if (triples_from_file.empty()) {
         std::cerr << "Warning: No data to visualize. The CSV file might be empty or missing." << std::endl;
     } else {
         graph.LoadTriples(triples_from_file);
-        graph.calculatePageRank();
     }
 
+    // The CSV is checked once a second; when it changes, new triples are placed incrementally
+    std::error_code file_error;
+    auto file_time = std::filesystem::last_write_time(filename, file_error);
+    double next_file_check = glfwGetTime() + 1.0;
+
+    // Once nothing moves the loop sleeps until input or the next check of the CSV file. A couple of frames
+    // are still drawn after each wake-up, which ImGui needs to settle hover and layout changes.
+    int frames_after_wake = 0;
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        if (frames_after_wake == 0 && graph.idle()) {
+            glfwWaitEventsTimeout(std::max(0.0, next_file_check - glfwGetTime()));
+            frames_after_wake = 2;
+        } else {
+            glfwPollEvents();
+            if (frames_after_wake > 0) frames_after_wake--;
+        }
+        if (glfwGetTime() >= next_file_check) {
+            next_file_check = glfwGetTime() + 1.0;
+            auto time = std::filesystem::last_write_time(filename, file_error);
+            if (!file_error && time != file_time) {
+                file_time = time;
+                std::vector<Triple> updated = LoadTriplesFromCSV(filename);
+                if (!updated.empty()) graph.UpdateTriples(updated);
+            }
+        }
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
-        graph.UpdatePhysics();
+        graph.SyncLayout();
+        graph.SyncAnalysis();
+        graph.SyncSimilarity();
         graph.Render();
         ImGui::Render();
         int display_w, display_h;
@@ -676,10 +6057,12 @@ int main() {
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
     }
+    graph.saveLayoutCache();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
+#endif
 }
\ No newline at end of file